@@ -0,0 +1,212 @@
+// micro-benchmarks for the allocator, pager, backing store and scheduler hot paths
+// links against the simulator library, prints one csv row per benchmark and parameter set:
+// benchmark,params,iterations,ns_per_op,ops_per_sec,allocs_per_op
+// gcc 11+ flags the malloc/free inside the replaced operators below as mismatched wherever they inline
+#if defined(__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+#include "simulator.h"
+#include <new>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+using namespace std;
+
+// every heap allocation, including the backing store thread's
+// new[] and delete[] forward to these
+atomic<long long> heapAllocs(0);
+
+void* operator new(size_t size) {
+    heapAllocs.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+double min_bench_seconds = 0.2;
+Simulator sim;
+
+// run op(iterations) with growing iteration counts until one run takes min_bench_seconds, then report it
+// op must leave the simulator in the state it found it so every iteration does the same work
+template <class Op>
+void bench(const string& name, const string& params, Op op) {
+    op(1); // warm up
+    long long iterations = 1;
+    while (true) {
+        long long allocsBefore = heapAllocs.load();
+        auto start = chrono::steady_clock::now();
+        op(iterations);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        long long allocs = heapAllocs.load() - allocsBefore;
+        if (seconds >= min_bench_seconds || iterations >= (1LL << 40)) {
+            cout << name << "," << params << "," << iterations << "," << std::fixed << std::setprecision(1)
+                 << seconds * 1e9 / iterations << "," << std::setprecision(0) << iterations / seconds << ","
+                 << std::setprecision(3) << allocs / (double)iterations << "\n";
+            cout.flush();
+            return;
+        }
+        // aim a little past the target so the next run is usually the last
+        double scale = seconds > 0 ? min_bench_seconds * 1.2 / seconds : 100;
+        iterations = max(iterations * 2, (long long)(iterations * min(scale, 100.0)));
+    }
+}
+
+// fresh simulator from a config, with empty run queues and idle cores
+void configure(const string& config) {
+    sim.BSFlush();
+    istringstream in(config);
+    sim.configure(in);
+    for (auto& q : sim.runQueues) {
+        for (auto& level : q.levels) level.clear();
+        q.length = 0;
+        q.bypassed = 0;
+    }
+    sim.initCores();
+}
+
+string baseConfig(int cpus, int totalMem, int frame, int ins) {
+    ostringstream config;
+    config << "num-cpu " << cpus << "\nscheduler \"rr\"\nquantum-cycles 5\nbatch-process-freq 0\n"
+           << "min-ins " << ins << "\nmax-ins " << ins << "\ndelay-per-exec 0\n"
+           << "max-overall-mem " << totalMem << "\nmem-per-frame " << frame << "\n"
+           << "min-mem-per-proc 64\nmax-mem-per-proc 64\ntrace 0\n";
+    return config.str();
+}
+
+// a process with mem bytes, not queued anywhere
+int benchProcess(int mem) {
+    int pid = sim.addProcess("");
+    sim.processes[pid].mem = mem;
+    sim.processes[pid].pages = sim.flat ? 0 : max(1, mem / sim.mem_per_frame);
+    return pid;
+}
+
+// AllocateFlat of a 128 byte process and the FlatDealloc that coalesces it back into the free tail,
+// behind holes 64 byte holes that no fit policy can use
+void benchFlat(const string& allocator, const string& fit, int holes) {
+    int mem = (holes * 2 + 64) * 128;
+    configure(baseConfig(1, mem, mem, 1) + "flat-allocator \"" + allocator + "\"\nfit-policy \"" + fit + "\"\n");
+    vector<int> fillers;
+    for (int i = 0; i < holes * 2; i++) {
+        fillers.push_back(benchProcess(64));
+        sim.AllocateFlat(fillers.back());
+    }
+    for (int i = 0; i < holes * 2; i += 2) sim.FlatDealloc(fillers[i]);
+    int pid = benchProcess(128);
+    bench("AllocateFlat+FlatDealloc", "allocator=" + (allocator == "buddy" ? allocator : fit) + ";holes=" + to_string(holes),
+          [&](long long n) {
+              for (long long i = 0; i < n; i++) {
+                  sim.AllocateFlat(pid);
+                  sim.FlatDealloc(pid);
+              }
+          });
+}
+
+// PagingAlloc of a process whose pages are all resident, then unpinning them as its slice ends
+void benchPagingAlloc(int frames, int pages) {
+    configure(baseConfig(1, frames * 64, 64, 1) + "page-replacement \"lru\"\n");
+    int pid = benchProcess(pages * 64);
+    sim.PagingAlloc(pid);
+    for (int page = 0; page < pages; page++) sim.AllocatePage(pid, page);
+    sim.ActivatePages(pid, false);
+    bench("PagingAlloc+unpin", "frames=" + to_string(frames) + ";pages=" + to_string(pages), [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            sim.PagingAlloc(pid);
+            sim.ActivatePages(pid, false);
+        }
+    });
+}
+
+// AllocatePage from the free list and freeing the frame again
+void benchAllocatePage(int frames, const string& policy) {
+    configure(baseConfig(1, frames * 64, 64, 1) + "page-replacement \"" + policy + "\"\n");
+    int pid = benchProcess(64);
+    sim.PagingAlloc(pid);
+    bench("AllocatePage+freeFrame", "frames=" + to_string(frames) + ";policy=" + policy, [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            sim.AllocatePage(pid, 0);
+            int key = sim.pageTables[pid].frames[0];
+            lock_guard<mutex> lk(sim.frameRegionMtx[key / FRAME_REGION_SIZE]);
+            sim.freeFrame(key);
+        }
+    });
+}
+
+// pageFault with every frame taken, so each fault evicts the policy's victim to the backing store
+void benchPageFault(int frames, const string& policy) {
+    configure(baseConfig(1, frames * 64, 64, 1) + "page-replacement \"" + policy + "\"\n");
+    int pid = benchProcess(frames * 2 * 64);
+    sim.PagingAlloc(pid);
+    int page = 0;
+    auto fault = [&]() {
+        sim.pageFault(pid, page);
+        int key = sim.pageTables[pid].frames[page];
+        // unpin it like the end of a slice would
+        lock_guard<mutex> lk(sim.frameRegionMtx[key / FRAME_REGION_SIZE]);
+        sim.frameMap[key].active = 0;
+        lock_guard<mutex> policyLk(sim.policyMtx);
+        sim.replacementPolicy->pin(key, false);
+        page = (page + 1) % sim.processes[pid].pages;
+    };
+    for (int i = 0; i < frames; i++) fault();
+    bench("pageFault(evicting)", "frames=" + to_string(frames) + ";policy=" + policy, [&](long long n) {
+        for (long long i = 0; i < n; i++) fault();
+    });
+    sim.BSFlush();
+}
+
+// BSStore followed by BSRetrieve, either taken back from the write-behind queue or after it hit the swap file
+void benchBackingStore(bool flushed) {
+    configure(baseConfig(1, 4096, 64, 1));
+    int pid = benchProcess(64);
+    bench("BSStore+BSRetrieve", flushed ? "path=swap-file" : "path=write-behind", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            sim.BSStore(pid);
+            if (flushed) sim.BSFlush();
+            sim.BSRetrieve(pid);
+            if (flushed) sim.BSFlush();
+        }
+    });
+}
+
+// one round robin tick, clock and every core's execution, with everything resident
+void benchTick(int cpus, int procs) {
+    configure(baseConfig(cpus, procs * 64 * 2, 64, 1000000));
+    for (int i = 0; i < procs; i++) sim.submitProcess(benchProcess(64));
+    bench("clockTick(rr)", "num-cpu=" + to_string(cpus) + ";processes=" + to_string(procs), [&](long long n) {
+        for (long long t = 0; t < n; t++) {
+            sim.clockTick();
+            for (int i = 0; i < sim.num_cpu; i++) {
+                if (sim.coreDue(sim.coreExecs[i]) && sim.coreProcesses[i].flagCounter > 0) sim.coreStep(i);
+            }
+        }
+    });
+}
+
+int main(int argc, char* argv[]) {
+    // usage: bench [seconds per benchmark]
+    if (argc >= 2) min_bench_seconds = atof(argv[1]);
+    cout << "benchmark,params,iterations,ns_per_op,ops_per_sec,allocs_per_op\n";
+    for (string fit : {"first-fit", "best-fit", "worst-fit", "next-fit"}) {
+        for (int holes : {0, 256, 4096}) benchFlat("free-list", fit, holes);
+    }
+    for (int holes : {0, 256, 4096}) benchFlat("buddy", "first-fit", holes);
+    for (int frames : {1024, 65536}) {
+        for (int pages : {1, 16}) benchPagingAlloc(frames, pages);
+    }
+    for (int frames : {1024, 65536}) {
+        for (string policy : {"fifo", "lru", "clock"}) benchAllocatePage(frames, policy);
+    }
+    for (int frames : {256, 4096}) {
+        for (string policy : {"fifo", "lru", "clock"}) benchPageFault(frames, policy);
+    }
+    benchBackingStore(false);
+    benchBackingStore(true);
+    for (int cpus : {1, 4, 16, 64}) {
+        for (int procs : {cpus * 2, 4096}) benchTick(cpus, procs);
+    }
+    sim.BSFlush();
+    sim.stopBSThread();
+    return 0;
+}
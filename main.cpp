@@ -1,963 +1,537 @@
-#include <iostream>
-#include <cstdlib>
-#include <cstring>
-#include <ctime>
-#include <map>
-#include <iomanip>
-#include <curses.h>
-#include <windows.h> // for windows
-#include <vector> 
-#include <algorithm>
-#include <cctype> 
-#include <thread>
-#include <fstream>
-#include <sstream>
-#include <deque>
-#include <cmath>
-#include <mutex>
-#include <filesystem>
-
-//#include <ncurses.h> //for mac
-//#include <unistd.h> // for mac
-using namespace std;
-
-namespace fs = std::filesystem;
-
-void clearDirectory(const std::string& path) {
-    try {
-        for (const auto& entry : fs::directory_iterator(path)) {
-            if (entry.is_regular_file()) {
-                fs::remove(entry.path()); 
-            }
-        }
-    } catch (const fs::filesystem_error& e) {
-        std::cerr << "Error: " << e.what() << std::endl;
-    }
-}
-
-void mainMenu();
-
-int cpu_cycles = 0;
-int num_cpu = 0;
-std::string scheduler;
-int quantum_cycles = 0;
-int batch_process_freq = 0;
-int min_ins = 0;
-int max_ins = 0;
-int delay_per_exec = 0;
-int max_overall_mem = 0;
-int mem_per_frame = 0;
-int min_mem_per_proc = 0;
-int max_mem_per_proc = 0;
-int initialized = 0;
-int pid = 0;
-int min_exp;
-int max_exp;
-int active_cpu_ticks = 0;
-int num_paged_in = 0;
-int num_paged_out = 0;
-int total_frames = 0;
-mutex mtx;
-
-// trim from the start (left)
-string ltrim(const string& str) {
-    size_t start = str.find_first_not_of(" \t\n\r");
-    return (start == string::npos) ? "" : str.substr(start);
-}
-
-// trim from the end (right)
-string rtrim(const string& str) {
-    size_t end = str.find_last_not_of(" \t\n\r");
-    return (end == string::npos) ? "" : str.substr(0, end + 1);
-}
-
-// trim from both ends 
-string trim(const string& str) {
-    return rtrim(ltrim(str));
-}
-
-// struct used for each new instance of a process screen
-struct ProcessScreen {
-    int pid;
-    string processName;
-    int currentLine;
-    int totalLines;
-    string timeStamp;
-    int core;
-    int mem;
-    int pages;
-};
-
-// struct for each core process 
-struct CoreProcess {
-    ProcessScreen process;  // current process the cpu is handling
-    int flagCounter;        // > 0 means cpu is executing something
-};
-
-// struct for the memory block
-struct MemoryBlock {
-    int start; // holds starting address of memory block
-    int end; // holds ending address of memory block
-    int pid; // process id that is using the memory block
-    int mem; // how much mem is in memory block
-    int age;
-    int active; // if mem block is currently in use by cpu
-};
-
-struct PIDAge {
-    int pid;
-    int age;
-    int active; // if frame is currently in use by cpu
-};
-
-map<int, PIDAge> frameMap;
-deque<int> freeFrameList;
-deque<MemoryBlock> freeMem; // vector to hold all free memory blocks
-deque<MemoryBlock> takenMem; // vector to hold all taken memory blocks
-bool flat = false;
-
-
-// compare by pid
-bool compareByPID(pair<string, ProcessScreen> a, pair<string, ProcessScreen> b) {
-    return a.second.pid < b.second.pid;
-}
-
-
-auto compByAddr = [] (MemoryBlock a, MemoryBlock b) {
-    return a.start < b.start;
-};
-
-// function to get local time stamp
-string getTimeStamp() {
-    time_t now = time(0);
-    tm* ltm = localtime(&now);
-    char buffer[80];
-    strftime(buffer, 80, "%m/%d/%Y, %I:%M:%S %p", ltm);
-
-    return string(buffer);
-}
-
-deque<ProcessScreen> scheduleQueue;
-map<string, ProcessScreen> processScreens; // map used for storing process screens, uses process name as key
-string currentScreen = "";
-vector<CoreProcess> coreProcesses; // for scheduler to keep track of what each core is doing
-int generating = false; // generating dummy processes
-
-void clearScreen() {
-    clear();
-    refresh();
-}
-
-ProcessScreen getProcByPid(int pid) {
-    for (auto& [key, screen] : processScreens) { 
-        if (screen.pid == pid) {
-            return screen;
-        }
-    }
-    ProcessScreen p;
-    return p; 
-}
-
-
-// for reprinting the header after clearing the screen
-void printHeader() {
-    clearScreen();
-    printw("\nHello, Welcome to CSOPESY commandline!\n");
-    printw(R"(  ____ ____   ___  ____  _____ ______   __
- / ___/ ___| / _ \|  _ \| ____/ ___\ \ / /
-| |   \___ \| | | | |_) |  _| \___ \\ V / 
-| |___ ___) | |_| |  __/| |___ ___) || |  
- \____|____/ \___/|_|   |_____|____/ |_|)");
-
-    attron(COLOR_PAIR(3));
-    printw("\nHello, Welcome to CSOPESY commandline!\n");
-    attron(COLOR_PAIR(2));
-    printw("Type 'exit' to quit, 'clear' to clear the screen\n");
-    attron(COLOR_PAIR(1));
-}
-
-void processSMI(ProcessScreen& ps) {
-    if (ps.currentLine < ps.totalLines) {
-        printw("\nProcess: %s\n", ps.processName.c_str());
-        printw("ID: %d\n\n", ps.pid);
-        printw("Current instruction line: %d\n", ps.currentLine);
-        printw("Lines of code: %d\n\n", ps.totalLines);
-    }
-    else if (ps.currentLine == ps.totalLines) {
-        printw("\nProcess: %s\n", ps.processName.c_str());
-        printw("ID: %d\n\n", ps.pid);
-        printw("Finished!\n\n");
-    }
-}
-
-// function for displaying new process screen information after screen -s is entered
-// note: the const string& basically allows the process name to still be referenced for screen -r
-void displayScreen(const string& processName) {
-    clearScreen();
-
-    ProcessScreen& ps = processScreens[processName];
-    printw("Process: %s\n", ps.processName.c_str());
-    printw("Instructions: %d/%d\n", ps.currentLine, ps.totalLines);
-    printw("Screen created at: %s\n", ps.timeStamp.c_str());
-
-    string input;
-    char buffer[100];
-    while (true) {
-        printw("Enter a command: ");
-        refresh();
-        wgetnstr(stdscr, buffer, sizeof(buffer) - 1);
-        input = buffer;
-
-        if (input == "exit") {
-            currentScreen = "";
-            printHeader();
-            break;
-        }
-        else if (input == "process-smi") {
-            processSMI(ps);
-        }
-        else {
-            printw("Command not recognized. Please try again.\n");
-        }
-    }
-}
-
-// merge blocks in freeMem
-void mergeAdjacentBlocks() {
-    if (freeMem.empty()) return;
-
-    std::deque<MemoryBlock> mergedBlocks;
-    mergedBlocks.push_back(freeMem[0]);
-
-    for (size_t i = 1; i < freeMem.size(); ++i) {
-        MemoryBlock& prev = mergedBlocks.back();
-        const MemoryBlock& current = freeMem[i];
-
-        if (prev.end + 1 == current.start) {
-            prev.end = current.end;
-            prev.mem += current.mem;
-        } else {
-            mergedBlocks.push_back(current);
-        }
-    }
-    freeMem = std::move(mergedBlocks);
-}
-
-
-void FlatDealloc(int pid) {
-    mtx.lock();
-    for (long long unsigned int i = 0; i < takenMem.size(); i++) {
-        MemoryBlock m = takenMem[i];
-        if (m.pid == pid) {
-            MemoryBlock mFree = {m.start, m.end, -1, m.mem, 0, 0};
-            freeMem.push_back(mFree);
-            sort(freeMem.begin(), freeMem.end(), compByAddr);
-            mergeAdjacentBlocks();
-            takenMem.erase(takenMem.begin()+i);
-            break;
-        }
-    }
-    mtx.unlock();
-    // remove from backing store
-    string filepath = "backing_store/" + to_string(pid) + ".txt";
-    std::ofstream file(filepath, std::ios::out);
-    file.close();  
-}
-
-void PageDealloc(int pid) {
-    // dealloc all pages from frame map
-    mtx.lock();
-    for (auto& [key, value] : frameMap) { 
-        if (pid == value.pid) {
-            value.active = 0;
-            value.age = 0;
-            value.pid = -1;
-        }
-    }
-    mtx.unlock();
-    // remove from backing store
-    string filepath = "backing_store/" + to_string(pid) + ".txt";
-    std::ofstream file(filepath, std::ios::out);
-    file.close();    
-}
-
-
-// add item to backing store
-void BSStore(int pid) {
-    if (pid == -1) return;
-    string filepath = "backing_store/" + to_string(pid) + ".txt";
-    std::ofstream file(filepath, std::ios::app);
-    file << pid << '\n';
-    file.close();
-}
-
-// remove item from backing store if exists
-void BSRetrieve(int pid) {
-    if (pid == -1) return;
-    string filepath = "backing_store/" + to_string(pid) + ".txt";
-
-    // read contents
-    ifstream file(filepath, ios::in);
-    if (!file.is_open()) return;
-    string line;
-    vector<string> lines;
-    while (getline(file, line)) {
-        lines.push_back(line);
-    }
-    file.close();
-
-    // remove last line
-    if (!lines.empty()) lines.pop_back();
-
-    // write updated contents
-    ofstream fileWrite(filepath, ios::out);
-    for (auto& l : lines) {
-        fileWrite << l << '\n';
-    }
-    fileWrite.close();
-}
-
-
-// function for each CORE
-void core(int cpu) {
-    int numActualExecs = 0; // how many times cpu was actually able to process smth
-    int additive = (scheduler == "fcfs" ? 1 : quantum_cycles);
-    while (true) {
-        if (ceil(cpu_cycles / (float)(delay_per_exec + 1)) >= numActualExecs) {
-            // sync with cpu_cycles
-            numActualExecs++;
-            if (coreProcesses[cpu].flagCounter > 0) {
-                // update both scheduleQueue and processScreens
-                coreProcesses[cpu].process.currentLine += additive; 
-                processScreens[coreProcesses[cpu].process.processName].currentLine += additive; 
-
-                // check if complete
-                if (coreProcesses[cpu].process.currentLine >= coreProcesses[cpu].process.totalLines) {
-                    if (flat == 1) FlatDealloc(coreProcesses[cpu].process.pid);
-                    else PageDealloc(coreProcesses[cpu].process.pid);
-                    coreProcesses[cpu].flagCounter = 0;
-                    continue;
-                }
-
-                // only proper executions will count towards quantum slice counter
-                if (scheduler == "rr") {
-                    if (flat == 1) {
-                        mtx.lock();
-                        for (long long unsigned int i = 0; i < takenMem.size(); i++) {
-                            MemoryBlock m = takenMem[i];
-                            if (m.pid == coreProcesses[cpu].process.pid) {
-                                MemoryBlock mFree = {m.start, m.end, -1, m.mem, 0, 0};
-                                freeMem.push_back(mFree);
-                                sort(freeMem.begin(), freeMem.end(), compByAddr);
-                                mergeAdjacentBlocks();
-                                takenMem.erase(takenMem.begin()+i);
-                                BSStore(coreProcesses[cpu].process.pid);
-                                break;
-                            }
-                        }
-                        mtx.unlock();
-                    } else {
-                        mtx.lock();
-                        for (auto& [key, value] : frameMap) { 
-                            if (coreProcesses[cpu].process.pid == value.pid) {
-                                frameMap[key].active = 0;
-                                frameMap[key].pid = -1;
-                                frameMap[key].age = 0;
-                            }
-                        }
-                        mtx.unlock();
-                    }
-                    coreProcesses[cpu].flagCounter = 0; // change to -- if need slow
-                }
-            }
-        }
-        napms(5);
-    }
-}
-
-
-// loads config.txt values onto the global variables
-void initializeProgram(const std::string& filename) {
-    std::ifstream configFile(filename);
-
-    if (!configFile) {
-        std::cerr << "Unable to open " << filename << " file" << std::endl;
-        return;
-    }
-
-    std::string line;
-    while (std::getline(configFile, line)) {
-        std::istringstream iss(line);
-        std::string key;
-
-        if (iss >> key) {
-            if (key == "num-cpu") {
-                iss >> num_cpu;
-            }
-            else if (key == "scheduler") {
-                iss >> scheduler;
-                // Remove the surrounding double quotes from the scheduler
-                if (!scheduler.empty() && scheduler[0] == '"') {
-                    scheduler = scheduler.substr(1, scheduler.size() - 2);
-                }
-            }
-            else if (key == "quantum-cycles") {
-                iss >> quantum_cycles;
-            }
-            else if (key == "batch-process-freq") {
-                iss >> batch_process_freq;
-            }
-            else if (key == "min-ins") {
-                iss >> min_ins;
-            }
-            else if (key == "max-ins") {
-                iss >> max_ins;
-            }
-            else if (key == "delay-per-exec") {
-                iss >> delay_per_exec;
-            }
-            else if (key == "max-overall-mem") {
-                iss >> max_overall_mem;
-            }
-            else if (key == "mem-per-frame") {
-                iss >> mem_per_frame;
-            }
-            else if (key == "min-mem-per-proc") {
-                iss >> min_mem_per_proc;
-            } 
-            else if (key == "max-mem-per-proc") {
-                iss >> max_mem_per_proc;
-            }
-        }
-    }
-
-    configFile.close();
-    initialized = 1;
-    min_exp = log2(min_mem_per_proc);
-    max_exp = log2(max_mem_per_proc);
-    if (max_overall_mem == mem_per_frame) {
-        flat = true;
-        MemoryBlock m = {0, max_overall_mem-1, -1, max_overall_mem, 0, 0};
-        freeMem.push_back(m);
-    } else {
-        flat = false;
-        total_frames = max_overall_mem / mem_per_frame;
-        for (int i = 0; i < total_frames; i++) {
-            freeFrameList.push_back(i);
-            frameMap[i] = {-1, 0, 0};
-        }
-    }
-    clearDirectory("./backing_store");
-}
-
-
-
-// allocation algo for flat 
-// search free mem for space, if available, alloc and ret 1, else 0
-bool AllocateFlat(ProcessScreen p) {
-    mtx.lock();
-    for (long long unsigned int i = 0; i < freeMem.size(); i++) {
-        MemoryBlock m = freeMem[i];
-        if (m.mem >= p.mem) {
-            MemoryBlock newTakenBlock = {m.start, m.start+p.mem - 1, p.pid, p.mem, 0, 1};
-            MemoryBlock leftoverBlock = {m.start+p.mem, m.end, -1, m.mem-p.mem, 0, 0};
-            freeMem.erase(freeMem.begin() + i);
-            takenMem.push_back(newTakenBlock);
-            if (m.start+p.mem < m.end) {
-                freeMem.push_back(leftoverBlock);
-                sort(freeMem.begin(), freeMem.end(), compByAddr);
-                mergeAdjacentBlocks();
-            }
-            mtx.unlock();
-            return 1;
-        }
-    }
-    mtx.unlock();
-    return 0;
-}
-
-// return 1 if proc in main mem
-int FlatMemAlloc(ProcessScreen process) {
-    // remove from backing store if exists
-    BSRetrieve(process.pid);
-
-    // try allocating mem, if cant, swap out oldest
-    ProcessScreen p = process;
-    while(!AllocateFlat(p)){
-        MemoryBlock m_oldest;
-
-        // remove oldest inactive from takenMem
-        mtx.lock();
-        long long unsigned int i;
-        for (i = 0; i < takenMem.size(); i++) {
-            if (takenMem[i].active == 0) {
-                BSStore(takenMem[i].pid);
-                m_oldest = {takenMem[i].start, takenMem[i].end, -1,  takenMem[i].mem, 0, 0};
-                takenMem.erase(takenMem.begin()+i);
-                break;
-            }
-        }
-        mtx.unlock();
-        // return if cant find any available space 
-        if (i == takenMem.size()) return 0;
-
-        // add to freeMem
-        mtx.lock();
-        freeMem.push_back(m_oldest);
-        sort(freeMem.begin(), freeMem.end(), compByAddr);
-        mergeAdjacentBlocks();
-        mtx.unlock();
-    }
-
-    return true;
-}
-
-bool AllocatePage(ProcessScreen p){
-    // look for free space
-    for (auto& [key, value] : frameMap) { 
-        if (value.pid == -1 && value.active == 0) {
-            frameMap[key].pid = p.pid;
-            frameMap[key].age = 0;
-            num_paged_in++;
-            return 1;
-        }
-    }
-    return 0;
-}
-
-// return 1 if all pages are in main mem
-int PagingAlloc(ProcessScreen process) {
-    // check if proc in mem
-    mtx.lock();
-    int associatedFrames = 0;
-    for (auto& [key, value] : frameMap) { 
-        if (process.pid == value.pid) {
-            associatedFrames++;
-        }
-    }
-    if (associatedFrames == process.pages) {
-        for (auto& [key, value] : frameMap) { 
-            if (process.pid == value.pid) {
-                frameMap[key].active = 1;
-            }
-        }
-        mtx.unlock();
-        return true;
-    }
-
-    // try allocate the rest of the needed pages
-    while (associatedFrames != process.pages) {
-
-        // remove from backing store if exists
-        BSRetrieve(process.pid);
-
-        // try allocating page, if cant, swap out oldest
-        while (!AllocatePage(process)) {
-            // find oldest inactive and remove
-            int oldestKey = 0;
-            int oldestAge = -1;
-            for (auto& [key, value] : frameMap) { 
-                if (oldestAge < value.age && value.active == 0 && value.pid != process.pid) {
-                    oldestAge = value.age;
-                    oldestKey = key;
-                } 
-            }
-            // return if cant find any available space 
-            if (oldestAge == -1) {
-                mtx.unlock();
-                return 0;
-            }
-            BSStore(frameMap[oldestKey].pid);
-            frameMap[oldestKey].age = 0;
-            frameMap[oldestKey].pid = -1;
-            frameMap[oldestKey].active = 0;
-            num_paged_out++;
-        }
-        associatedFrames++;
-    }
-    for (auto& [key, value] : frameMap) { 
-        if (process.pid == value.pid) {
-            frameMap[key].active = 1;
-        }
-    }
-    mtx.unlock();
-    return true;
-}
-
-
-void RRScheduler() {
-    int active = 0;
-    for (int i = 0; i < num_cpu; i++) {
-        if (coreProcesses[i].flagCounter == 0) {
-            // if process is not completed, add back to ready/waiting queue
-            if (coreProcesses[i].process.processName != "" && coreProcesses[i].process.currentLine < coreProcesses[i].process.totalLines) {
-                scheduleQueue.push_back(coreProcesses[i].process);
-                coreProcesses[i].process.processName = "";
-            }
-
-            // update assigned core on queues
-            if (!scheduleQueue.empty()) {
-                ProcessScreen p = scheduleQueue.front();
-                scheduleQueue.pop_front();
-                //printw("!%d!", scheduleQueue.size());
-                //printw("---%d---\n", i);
-                //for (auto& s : scheduleQueue) printw("-%s-", s.processName.c_str());
-                //printw("\n");
-                //printw(" !pid:%d %d/%d core%d! ", p.pid, p.currentLine, p.totalLines, i);
-                if ((flat == 1 && FlatMemAlloc(p)) || (flat == 0 && PagingAlloc(p))) {
-                    coreProcesses[i].process = p;
-                    coreProcesses[i].process.core = i;
-                    processScreens[coreProcesses[i].process.processName].core = i;
-                    coreProcesses[i].flagCounter = quantum_cycles;      
-                } else {
-                    scheduleQueue.push_back(p);
-                }
-            }
-        } else {
-            active = 1;
-        }
-    }
-    if (active) active_cpu_ticks++;
-}
-
-void FCFSScheduler() {
-    /*
-    mtx.lock();
-    printw("\n");
-    for (auto& [key, value] : frameMap) printw("-%d %d %d %d %d-\n", key, value.pid, value.age, value.active, getProcByPid(value.pid).mem);
-    printw("=====\n");
-    for (auto& cp : coreProcesses) printw("%d %d %d\n", cp.process.pid, cp.process.mem, cp.process.pages);
-    printw("\n");
-    mtx.unlock();
-    */
-    int active = 0;
-    for (int i = 0; i < num_cpu; i++) {
-        if (coreProcesses[i].flagCounter == 0 && !scheduleQueue.empty()) {
-            ProcessScreen p = scheduleQueue.front();
-            scheduleQueue.pop_front();
-            if ((flat == 1 && FlatMemAlloc(p)) || (flat == 0 && PagingAlloc(p))) {
-                coreProcesses[i].process = p;
-                coreProcesses[i].process.core = i;
-                processScreens[coreProcesses[i].process.processName].core = i;
-                coreProcesses[i].flagCounter = 1;      
-            } else {
-                scheduleQueue.push_back(p);
-            }
-        } else if (coreProcesses[i].flagCounter != 0) {
-            active = 1;
-        }
-    }
-    if (active) active_cpu_ticks++;
-}
-
-
-void startClock() {
-    for (int i = 0; i < num_cpu; i++) {
-        thread t(core, i);
-        t.detach();
-        CoreProcess cp;
-        cp.flagCounter = 0;
-        coreProcesses.push_back(cp);
-    }
-
-    while (true) {
-        cpu_cycles++;
-        if (flat == 0) {
-            for (auto& [key, value] : frameMap) { 
-                if (value.pid != -1) value.age++;
-            }
-        }
-        if (scheduler == "fcfs") {
-            FCFSScheduler();
-        }
-        else {
-            RRScheduler();
-        }
-        
-        if (generating == true && batch_process_freq != 0 && cpu_cycles % batch_process_freq == 0) {
-            string proposedName = "p" + to_string(pid);
-            // in case user uses screen -s with the same name
-            while (processScreens.find(proposedName) != processScreens.end()) {
-                pid++;
-                proposedName = "p" + to_string(pid);
-            }
-            int M = pow(2, rand() % (max_exp - min_exp + 1) + min_exp);
-            ProcessScreen newScreen = { pid, proposedName, 0, rand() % (max_ins - min_ins + 1) + min_ins, getTimeStamp(), -1, M, M/mem_per_frame};
-            pid++;
-            processScreens[proposedName] = newScreen;
-            scheduleQueue.push_back(newScreen);
-        }
-        napms(10); // sleep, milliseconds
-    }
-}
-
-void mainMenu() {
-    printHeader();
-    bool run = true; // flag for running or ending loop
-    char buffer[100];
-    string input;
-
-    // loop for command line choices
-    while (run) {
-        printw("Enter a command: ");
-        refresh();
-
-        wgetnstr(stdscr, buffer, sizeof(buffer) - 1);
-        input = buffer;
-
-        if (initialized == 0 && (input == "initialize" || input == "exit")) {
-            if (input == "initialize") {
-                initializeProgram("config.txt");
-                printw("Program initialized. Obtained data from config.txt.\n");
-                thread t(startClock);
-                t.detach();
-            }
-            else {
-                run = false;
-            }
-        }
-        else if (initialized == 0 && input != "initialize") {
-            printw("Command is invalid. Please initialize the program first.\n");
-        }
-        else {
-            if (input == "initialize") {
-                initializeProgram("config.txt");
-                printw("Program initialized. Obtained data from config.txt.\n");
-            }
-            else if (input.find("screen -s") == 0) {
-                string processName = trim(input.substr(9));
-                if (processName == "") {
-                    printw("Can't have a blank process name.\n");
-                } else if (processScreens.find(processName) == processScreens.end()) {
-                    int M = pow(2, rand() % (max_exp - min_exp + 1) + min_exp);
-                    ProcessScreen newScreen = { pid, processName, 0, rand() % (max_ins - min_ins + 1) + min_ins, getTimeStamp(), -1, M, M/mem_per_frame };
-                    pid++;
-                    processScreens[processName] = newScreen;
-                    scheduleQueue.push_back(newScreen);
-                    currentScreen = processName;
-                    displayScreen(processName);
-                } else {
-                    printw("Process %s already exists.\n", processName.c_str());
-                }
-            }
-            else if (input.find("screen -r") == 0) {
-                string processName = trim(input.substr(9));
-                ProcessScreen& ps = processScreens[processName];
-                if (processScreens.find(processName) != processScreens.end() && ps.currentLine != ps.totalLines) {
-                    currentScreen = processName;
-                    displayScreen(processName);
-                }
-                else if (ps.currentLine == ps.totalLines) {
-                    printw("Process '%s' has already finished.\n", processName.c_str());
-                    currentScreen = "";
-                }
-                else {
-                    printw("Process '%s' not found.\n", processName.c_str());
-                    currentScreen = "";
-                }
-            }
-            else if (input.find("screen -ls") == 0) {
-                string formatTime;
-                ProcessScreen p;
-
-                int active_cores = 0;
-                //int unfinishedProcesses = scheduleQueue.size();
-                /*
-                for (int i = 0; i < num_cpu; i++) {
-                    if (coreProcesses[i].process.processName != "" && coreProcesses[i].process.currentLine != coreProcesses[i].process.totalLines) {
-                        unfinishedProcesses++;
-                    }
-                } */
-
-                for (int i = 0; i < num_cpu; i++) {
-                    if (coreProcesses[i].flagCounter > 0) {
-                        active_cores++;
-                    }
-                }
-                //active_cores = unfinishedProcesses < num_cpu ? unfinishedProcesses : num_cpu;
-                float utilization = (active_cores / (float)num_cpu) * 100;
-                
-                printw("CPU utilization: %3.2f%%\n", utilization);
-                printw("Cores used: %d\n", active_cores);
-                printw("Cores available: %d", num_cpu - active_cores);
-                printw("\n\n--------------------------------------");
-
-                printw("\nRunning processes: \n");
-                for (int i = 0; i < num_cpu; i++) {
-                    if (coreProcesses[i].flagCounter > 0 && coreProcesses[i].process.processName != "" && coreProcesses[i].process.currentLine < coreProcesses[i].process.totalLines) {
-                        p = coreProcesses[i].process;
-                        formatTime = p.timeStamp;
-                        formatTime.erase(10, 1);
-                        printw("%s\t(%s)\tCore: %d\t\t%d / %d\n", p.processName.c_str(), formatTime.c_str(), p.core, p.currentLine, p.totalLines);
-                    }
-                }
-                printw("\nFinished processes: \n");
-                vector<pair<string, ProcessScreen>> sortedMap;
-
-                for (const auto& it : processScreens) {
-                    sortedMap.push_back(it);
-                }
-                sort(sortedMap.begin(), sortedMap.end(), compareByPID);
-                for (auto& it : sortedMap) {
-                    p = it.second;
-                    if (p.currentLine >= p.totalLines) {
-                        formatTime = p.timeStamp;
-                        formatTime.erase(10, 1);
-                        printw("%s\t(%s)\tCore: %d\t\t%d / %d\n", p.processName.c_str(), formatTime.c_str(), p.core, p.totalLines, p.totalLines);
-                    }
-                }
-
-                printw("\n--------------------------------------\n\n");
-            }
-            else if (input == "scheduler-test") {
-                if (generating == true) {
-                    printw("Already generating dummy processes...\n");
-                }
-                else {
-                    generating = true;
-                    printw("Generating dummy processes...\n");
-                }
-            }
-            else if (input == "scheduler-stop") {
-                if (generating == false) {
-                    printw("Already stopped generating dummy processes...\n");
-                }
-                else {
-                    generating = false;
-                    printw("Stopped generating dummy processes...\n");
-                }
-            }
-            else if (input == "report-util") {
-                string formatTime;
-                ProcessScreen p;
-
-                int active_cores = 0;
-                //int unfinishedProcesses = scheduleQueue.size();
-                /*
-                for (int i = 0; i < num_cpu; i++) {
-                    if (coreProcesses[i].process.processName != "" && coreProcesses[i].process.currentLine != coreProcesses[i].process.totalLines) {
-                        unfinishedProcesses++;
-                    }
-                }
-                */
-
-                 for (int i = 0; i < num_cpu; i++) {
-                    if (coreProcesses[i].flagCounter > 0) {
-                        active_cores++;
-                    }
-                }
-                // active_cores = unfinishedProcesses < num_cpu ? unfinishedProcesses : num_cpu;
-                float utilization = (active_cores / (float)num_cpu) * 100;
-
-                std::ofstream logFile("csopesy-log.txt", std::ios::out);
-
-                logFile << "CPU utilization: " << std::fixed << std::setprecision(2) << utilization << "%\n";
-                logFile << "Cores used: " << active_cores << "\n";
-                logFile << "Cores available: " << num_cpu - active_cores << "\n";
-                logFile << "\n--------------------------------------\n";
-
-                logFile << "Running processes: \n";
-                for (int i = 0; i < num_cpu; i++) {
-                    if (coreProcesses[i].flagCounter > 0 && coreProcesses[i].process.processName != "" && coreProcesses[i].process.currentLine < coreProcesses[i].process.totalLines) {
-                        p = coreProcesses[i].process;
-                        formatTime = p.timeStamp;
-                        formatTime.erase(10, 1);
-                        logFile << p.processName << "\t(" << formatTime << ")\tCore: " << p.core
-                            << "\t\t" << p.currentLine << " / " << p.totalLines << "\n";
-                    }
-                }
-
-                logFile << "\nFinished processes: \n";
-                vector<pair<string, ProcessScreen>> sortedMap;
-            
-                for (const auto& it : processScreens) {
-                    sortedMap.push_back(it);
-                }
-                sort(sortedMap.begin(), sortedMap.end(), compareByPID);
-                for (auto& it : sortedMap) {
-                    p = it.second;
-                    if (p.currentLine >= p.totalLines) {
-                        formatTime = p.timeStamp;
-                        formatTime.erase(10, 1);
-                        logFile << p.processName << "\t(" << p.timeStamp << ")\tCore: " << p.core
-                            << "\t\t" << p.totalLines << " / " << p.totalLines << "\n";
-                    }
-                }
-
-                logFile << "\n--------------------------------------\n\n";
-
-                logFile.close();
-            }
-            else if (input == "clear") {
-                clearScreen();
-                printHeader();
-            }
-            else if (input == "process-smi") {
-                int active_cores = 0;
-                int mem_used = 0;
-                vector<ProcessScreen> running; 
-                mtx.lock();
-                 for (int i = 0; i < num_cpu; i++) {
-                    if (coreProcesses[i].flagCounter > 0) {
-                        active_cores++;
-                        running.push_back(coreProcesses[i].process);
-                        mem_used += coreProcesses[i].process.mem;
-                    }
-                }
-                mtx.unlock();
-                float utilization = (active_cores / (float)num_cpu) * 100;
-                printw("------------------------------------------- \n");
-                printw("PROCESS-SMI V01.00: \n");
-                printw("CPU Util: %3.2f%%\n", utilization);
-                printw("Memory Usage: %d MiB / %d MiB\n", mem_used, max_overall_mem);
-                printw("Memory Util: %3.2f%%\n\n", mem_used / (float) max_overall_mem * 100);
-                printw("Running processes and memory usage: \n");
-                for (auto& p : running) {
-                    printw("%s %d MiB\n", p.processName.c_str(), p.mem);
-                }
-                printw("------------------------------------------- \n");
-                printw("\n");
-
-            } else if (input == "vmstat") {
-                int mem_used = 0;
-                 for (int i = 0; i < num_cpu; i++) {
-                    if (coreProcesses[i].flagCounter > 0) {
-                        mem_used += coreProcesses[i].process.mem;
-                    }
-                }
-                printw("------------------------------------------- \n");
-                printw("Total memory: %d\n", max_overall_mem);
-                printw("Used memory: %d\n", mem_used);
-                printw("Free memory: %d\n", max_overall_mem - mem_used); // idk if free mem includes mem blocks that are in memory but are just from prev processes that arent in use anymore
-                printw("Idle cpu ticks: %d\n", cpu_cycles-active_cpu_ticks);
-                printw("Active cpu ticks: %d\n", active_cpu_ticks);
-                printw("Total cpu ticks: %d\n", cpu_cycles);
-                printw("Num paged in: %d\n", num_paged_in);
-                printw("Num paged out: %d\n", num_paged_out);
-                printw("------------------------------------------- \n");
-
-            }
-            else if (input == "exit") {
-                run = false;
-            }
-            else {
-                printw("Command not recognized. Please try again.\n");
-            }
-        }
-        refresh();
-    }
-}
-
-int main() {
-    initscr();
-    start_color();
-    scrollok(stdscr, TRUE);
-    init_pair(1, COLOR_WHITE, COLOR_BLACK);
-    init_pair(2, COLOR_YELLOW, COLOR_BLACK);
-    init_pair(3, COLOR_GREEN, COLOR_BLACK);
-    cbreak();
-    mainMenu();
-    refresh();
-    endwin();
-    return 0;
-}
\ No newline at end of file
+#include <iostream>
+#include <cstdlib>
+#include <iomanip>
+#include <curses.h>
+#include <vector> 
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include "simulator.h"
+
+//#include <ncurses.h> //for mac
+using namespace std;
+
+void mainMenu();
+
+Simulator sim;
+
+// trim from the start (left)
+string ltrim(const string& str) {
+    size_t start = str.find_first_not_of(" \t\n\r");
+    return (start == string::npos) ? "" : str.substr(start);
+}
+
+// trim from the end (right)
+string rtrim(const string& str) {
+    size_t end = str.find_last_not_of(" \t\n\r");
+    return (end == string::npos) ? "" : str.substr(0, end + 1);
+}
+
+// trim from both ends 
+string trim(const string& str) {
+    return rtrim(ltrim(str));
+}
+string currentScreen = "";
+
+void clearScreen() {
+    clear();
+    refresh();
+}
+
+
+// for reprinting the header after clearing the screen
+void printHeader() {
+    clearScreen();
+    printw("\nHello, Welcome to CSOPESY commandline!\n");
+    printw(R"(  ____ ____   ___  ____  _____ ______   __
+ / ___/ ___| / _ \|  _ \| ____/ ___\ \ / /
+| |   \___ \| | | | |_) |  _| \___ \\ V / 
+| |___ ___) | |_| |  __/| |___ ___) || |  
+ \____|____/ \___/|_|   |_____|____/ |_|)");
+
+    attron(COLOR_PAIR(3));
+    printw("\nHello, Welcome to CSOPESY commandline!\n");
+    attron(COLOR_PAIR(2));
+    printw("Type 'exit' to quit, 'clear' to clear the screen\n");
+    attron(COLOR_PAIR(1));
+}
+
+void processSMI(ProcessScreen& ps) {
+    if (ps.currentLine < ps.totalLines) {
+        printw("\nProcess: %s\n", ps.processName.c_str());
+        printw("ID: %d\n\n", ps.pid);
+        printw("Current instruction line: %d\n", ps.currentLine);
+        printw("Lines of code: %d\n", ps.totalLines);
+        printw("Hello world from %s! (printed %d times)\n", ps.processName.c_str(), ps.prints);
+        if (ps.tlbHits + ps.tlbMisses > 0) printw("TLB hits: %lld, misses: %lld\n", ps.tlbHits, ps.tlbMisses);
+        if (ps.firstDispatchTick == -1) printw("Arrived at tick %d, not dispatched yet\n", ps.arrivalTick);
+        else printw("Arrived at tick %d, first dispatched at %d, waited %d ticks\n", ps.arrivalTick, ps.firstDispatchTick, ps.waitTicks);
+        printw("\n");
+    }
+    else if (ps.currentLine == ps.totalLines) {
+        printw("\nProcess: %s\n", ps.processName.c_str());
+        printw("ID: %d\n\n", ps.pid);
+        printw("Finished!\n");
+        printw("Turnaround %d ticks, waited %d, response %d\n\n", ps.completionTick - ps.arrivalTick, ps.waitTicks,
+               ps.firstDispatchTick - ps.arrivalTick);
+    }
+}
+
+// function for displaying new process screen information after screen -s is entered
+// note: the const string& basically allows the process name to still be referenced for screen -r
+void displayScreen(const string& processName) {
+    clearScreen();
+
+    ProcessScreen& ps = sim.processes[sim.findProcess(processName)];
+    printw("Process: %s\n", ps.processName.c_str());
+    printw("Instructions: %d/%d\n", ps.currentLine, ps.totalLines);
+    printw("Screen created at: %s\n", ps.timeStamp.c_str());
+
+    string input;
+    char buffer[100];
+    while (true) {
+        printw("Enter a command: ");
+        refresh();
+        wgetnstr(stdscr, buffer, sizeof(buffer) - 1);
+        input = buffer;
+
+        if (input == "exit") {
+            currentScreen = "";
+            printHeader();
+            break;
+        }
+        else if (input == "process-smi") {
+            processSMI(ps);
+        }
+        else {
+            printw("Command not recognized. Please try again.\n");
+        }
+    }
+}
+
+// headless turbo mode: no curses, no sleeps, cores are stepped in lockstep with the clock
+// a snapshot to restore replaces the config, the checkpoint is written after the last tick
+// a workload to replay replaces the generator, a recording gets every arrival of the run
+int runHeadless(long long ticks, const string& configPath, const string& restorePath, const string& checkpointPath,
+                const string& replayPath, const string& recordPath) {
+    if (restorePath != "") {
+        if (!sim.restore(restorePath)) {
+            cerr << sim.error << endl;
+            return 1;
+        }
+    } else {
+        if (!sim.configure(configPath)) {
+            cerr << sim.error << endl;
+            return 1;
+        }
+        sim.generating = replayPath == "";
+    }
+    if (replayPath != "" && !sim.replayWorkload(replayPath)) {
+        cerr << "Unable to replay " << replayPath << endl;
+        return 1;
+    }
+    if (recordPath != "" && !sim.recordWorkload(recordPath)) {
+        cerr << "Unable to record to " << recordPath << endl;
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    sim.run(ticks);
+    sim.BSFlush();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (checkpointPath != "" && !sim.checkpoint(checkpointPath)) cerr << "Unable to write " << checkpointPath << endl;
+    if (recordPath != "") {
+        sim.stopRecording();
+        cout << "Arrivals recorded: " << sim.num_recorded << " (" << recordPath << ")\n";
+    }
+
+    sim.writeReportUtil(cout);
+    sim.writeVmstat(cout);
+    sim.stopBSThread();
+    if (sim.tracing) {
+        std::ofstream traceFile("csopesy-trace.json");
+        cout << "Trace events exported: " << sim.exportTrace(traceFile) << " (csopesy-trace.json)\n";
+    }
+    cout << "Headless ticks: " << ticks << "\n";
+    cout << "Wall time: " << std::fixed << std::setprecision(3) << seconds << " s\n";
+    cout << "Ticks per second: " << std::fixed << std::setprecision(0) << (seconds > 0 ? ticks / seconds : 0.0) << "\n";
+    cout << "Instructions per second: " << std::fixed << std::setprecision(0) << (seconds > 0 ? sim.stats().instructions / seconds : 0.0) << "\n";
+    return 0;
+}
+
+// one point of a sweep, its overrides and the csv row it produced
+struct SweepPoint {
+    vector<string> values; // one per grid key
+    string row;
+};
+
+// parameter sweep: every combination of the grid file's values runs as its own headless simulation
+// the grid file has one "key value value ..." line per swept config.txt key, everything else comes from the base config
+// points are spread over one thread per host core and written to csv in grid order
+int runSweep(long long ticks, const string& gridPath, const string& configPath, const string& csvPath) {
+    std::ifstream gridFile(gridPath);
+    std::ifstream configFile(configPath);
+    if (!gridFile || !configFile) {
+        cerr << "Unable to open " << (!gridFile ? gridPath : configPath) << " file" << endl;
+        return 1;
+    }
+    ostringstream base;
+    base << configFile.rdbuf();
+
+    vector<string> keys;
+    vector<vector<string>> grid;
+    string line;
+    while (getline(gridFile, line)) {
+        istringstream iss(line);
+        string key, value;
+        if (!(iss >> key) || key[0] == '#') continue;
+        vector<string> values;
+        while (iss >> value) values.push_back(value);
+        if (values.empty()) continue;
+        keys.push_back(key);
+        grid.push_back(values);
+    }
+
+    // last key varies fastest
+    vector<SweepPoint> points(1);
+    for (auto& values : grid) {
+        vector<SweepPoint> next;
+        for (auto& p : points) {
+            for (auto& v : values) {
+                next.push_back(p);
+                next.back().values.push_back(v);
+            }
+        }
+        points = next;
+    }
+
+    atomic<int> nextPoint{0};
+    atomic<int> done{0};
+    auto worker = [&]() {
+        for (int i = nextPoint++; i < (int)points.size(); i = nextPoint++) {
+            SweepPoint& point = points[i];
+            // later lines win, so the overrides go after the base config
+            string config = base.str() + "\n";
+            for (int k = 0; k < (int)keys.size(); k++) config += keys[k] + " " + point.values[k] + "\n";
+
+            Simulator s;
+            istringstream in(config);
+            ostringstream row;
+            for (auto& v : point.values) row << v << ",";
+            // a bad value costs its point a row, not the sweep
+            if (!s.configure(in)) {
+                point.row = row.str() + "config error";
+                cerr << "Sweep point " << ++done << "/" << points.size() << " " << s.error << "\n";
+                continue;
+            }
+            s.generating = true;
+            auto start = chrono::steady_clock::now();
+            s.run(ticks);
+            s.BSFlush();
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            s.stopBSThread();
+            SimStats st = s.stats();
+            long long refs = st.tlbHits + st.tlbMisses;
+            row << std::fixed << std::setprecision(3) << seconds << "," << std::setprecision(0) << (seconds > 0 ? ticks / seconds : 0.0)
+                << "," << st.processes << "," << st.finished << "," << std::setprecision(3) << st.finished * 1000.0 / max(st.ticks, 1LL)
+                << "," << std::setprecision(2) << st.activeTicks * 100.0 / max(st.ticks, 1LL) << "," << st.cpuUtilization
+                << "," << st.instructions << "," << st.dispatchFailures << "," << st.pagedIn << "," << st.pagedOut
+                << "," << st.majorFaults << "," << st.minorFaults << "," << (refs > 0 ? st.tlbHits * 100.0 / refs : 0.0);
+            long long* hists[] = {st.turnaround, st.waiting, st.response};
+            for (int h = 0; h < 3; h++) {
+                row << "," << std::setprecision(1) << st.mean[h];
+                for (int q = 0; q < 4; q++) row << "," << hists[h][q];
+            }
+            point.row = row.str();
+            cerr << "Sweep point " << ++done << "/" << points.size() << " done\n";
+        }
+    };
+    int threads = max(1, min((int)thread::hardware_concurrency(), (int)points.size()));
+    auto start = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(worker);
+    for (auto& t : pool) t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    std::ofstream csv(csvPath);
+    for (auto& key : keys) csv << key << ",";
+    csv << "wall_s,ticks_per_s,processes,finished,finished_per_1k_ticks,active_tick_pct,cpu_util_pct,instructions,"
+        << "dispatch_failures,paged_in,paged_out,major_faults,minor_faults,tlb_hit_pct";
+    for (string hist : {"turnaround", "waiting", "response"}) {
+        for (string q : {"mean", "p50", "p90", "p99", "max"}) csv << "," << hist << "_" << q;
+    }
+    csv << "\n";
+    for (auto& p : points) csv << p.row << "\n";
+    cout << "Sweep: " << points.size() << " points x " << ticks << " ticks on " << threads << " threads in " << std::fixed
+         << std::setprecision(3) << seconds << " s (" << csvPath << ")\n";
+    return 0;
+}
+
+void mainMenu() {
+    printHeader();
+    bool run = true; // flag for running or ending loop
+    char buffer[100];
+    string input;
+
+    // loop for command line choices
+    while (run) {
+        printw("Enter a command: ");
+        refresh();
+
+        wgetnstr(stdscr, buffer, sizeof(buffer) - 1);
+        input = buffer;
+
+        if (sim.initialized == 0 && (input == "initialize" || input == "exit")) {
+            if (input == "initialize") {
+                if (sim.configure("config.txt")) {
+                    printw("Program initialized. Obtained data from config.txt.\n");
+                    sim.start();
+                } else {
+                    printw("%s\n", sim.error.c_str());
+                }
+            }
+            else {
+                run = false;
+            }
+        }
+        else if (sim.initialized == 0 && input != "initialize") {
+            printw("Command is invalid. Please initialize the program first.\n");
+        }
+        else {
+            if (input == "initialize") {
+                if (sim.configure("config.txt")) printw("Program initialized. Obtained data from config.txt.\n");
+                else printw("%s\n", sim.error.c_str());
+            }
+            else if (input.find("screen -s") == 0) {
+                string processName = trim(input.substr(9));
+                if (processName == "") {
+                    printw("Can't have a blank process name.\n");
+                } else if (sim.findProcess(processName) == -1) {
+                    sim.submitProcess(sim.addProcess(processName));
+                    currentScreen = processName;
+                    displayScreen(processName);
+                } else {
+                    printw("Process %s already exists.\n", processName.c_str());
+                }
+            }
+            else if (input.find("screen -r") == 0) {
+                string processName = trim(input.substr(9));
+                int found = sim.findProcess(processName);
+                if (found != -1 && sim.processes[found].currentLine < sim.processes[found].totalLines) {
+                    currentScreen = processName;
+                    displayScreen(processName);
+                }
+                else if (found != -1) {
+                    printw("Process '%s' has already finished.\n", processName.c_str());
+                    currentScreen = "";
+                }
+                else {
+                    printw("Process '%s' not found.\n", processName.c_str());
+                    currentScreen = "";
+                }
+            }
+            else if (input.find("screen -ls") == 0) {
+                string formatTime;
+                ProcessScreen p;
+
+                int active_cores = 0;
+                //int unfinishedProcesses = runQueueLength();
+                /*
+                for (int i = 0; i < sim.num_cpu; i++) {
+                    if (sim.coreProcesses[i].pid != -1 && sim.processes[sim.coreProcesses[i].pid].currentLine != sim.processes[sim.coreProcesses[i].pid].totalLines) {
+                        unfinishedProcesses++;
+                    }
+                } */
+
+                for (int i = 0; i < sim.num_cpu; i++) {
+                    if (sim.coreProcesses[i].flagCounter > 0) {
+                        active_cores++;
+                    }
+                }
+                //active_cores = unfinishedProcesses < num_cpu ? unfinishedProcesses : num_cpu;
+                float utilization = (active_cores / (float)sim.num_cpu) * 100;
+                
+                printw("CPU utilization: %3.2f%%\n", utilization);
+                printw("Cores used: %d\n", active_cores);
+                printw("Cores available: %d", sim.num_cpu - active_cores);
+                printw("\n\n--------------------------------------");
+
+                printw("\nRunning processes: \n");
+                for (int i = 0; i < sim.num_cpu; i++) {
+                    if (sim.coreProcesses[i].flagCounter > 0 && sim.coreProcesses[i].pid != -1 && sim.processes[sim.coreProcesses[i].pid].currentLine < sim.processes[sim.coreProcesses[i].pid].totalLines) {
+                        p = sim.processes[sim.coreProcesses[i].pid];
+                        formatTime = p.timeStamp;
+                        formatTime.erase(10, 1);
+                        printw("%s\t(%s)\tCore: %d\t\t%d / %d\n", p.processName.c_str(), formatTime.c_str(), p.core, p.currentLine, p.totalLines);
+                    }
+                }
+                printw("\nFinished processes: \n");
+                int count = sim.processes.size();
+                for (int i = 0; i < count; i++) {
+                    p = sim.processes[i];
+                    if (p.pid != -1 && p.currentLine >= p.totalLines) {
+                        formatTime = p.timeStamp;
+                        formatTime.erase(10, 1);
+                        printw("%s\t(%s)\tCore: %d\t\t%d / %d\n", p.processName.c_str(), formatTime.c_str(), p.core, p.totalLines, p.totalLines);
+                    }
+                }
+
+                printw("\n--------------------------------------\n\n");
+            }
+            else if (input == "scheduler-test") {
+                if (sim.generating == true) {
+                    printw("Already generating dummy processes...\n");
+                }
+                else {
+                    sim.generating = true;
+                    printw("Generating dummy processes...\n");
+                }
+            }
+            else if (input == "scheduler-stop") {
+                if (sim.generating == false) {
+                    printw("Already stopped generating dummy processes...\n");
+                }
+                else {
+                    sim.generating = false;
+                    printw("Stopped generating dummy processes...\n");
+                }
+            }
+            else if (input == "report-util") {
+                std::ofstream logFile("csopesy-log.txt", std::ios::out);
+                sim.writeReportUtil(logFile);
+                logFile.close();
+            }
+            else if (input == "clear") {
+                clearScreen();
+                printHeader();
+            }
+            else if (input == "process-smi") {
+                int active_cores = 0;
+                int mem_used = sim.usedMemory();
+                vector<ProcessScreen> running; 
+                 for (int i = 0; i < sim.num_cpu; i++) {
+                    if (sim.coreProcesses[i].flagCounter > 0) {
+                        active_cores++;
+                        running.push_back(sim.processes[sim.coreProcesses[i].pid]);
+                    }
+                }
+                float utilization = (active_cores / (float)sim.num_cpu) * 100;
+                printw("------------------------------------------- \n");
+                printw("PROCESS-SMI V01.00: \n");
+                printw("CPU Util: %3.2f%%\n", utilization);
+                printw("Memory Usage: %d MiB / %d MiB\n", mem_used, sim.max_overall_mem);
+                printw("Memory Util: %3.2f%%\n\n", mem_used / (float) sim.max_overall_mem * 100);
+                ostringstream latency;
+                sim.writeLatency(latency);
+                printw("%s\n", latency.str().c_str());
+                if (sim.flat == 0 && sim.tlb_entries > 0) {
+                    long long hits, misses, shootdowns, flushes;
+                    sim.tlbTotals(hits, misses, shootdowns, flushes);
+                    printw("TLB hits: %lld, misses: %lld, shootdowns: %lld\n\n", hits, misses, shootdowns);
+                }
+                printw("Running processes and memory usage: \n");
+                for (auto& p : running) {
+                    printw("%s %d MiB\n", p.processName.c_str(), p.mem);
+                }
+                printw("------------------------------------------- \n");
+                printw("\n");
+
+            } else if (input == "trace-on") {
+                sim.tracing = true;
+                printw("Tracing scheduler and paging events.\n");
+            } else if (input == "trace-off") {
+                sim.tracing = false;
+                printw("Tracing stopped.\n");
+            } else if (input.find("trace-export") == 0) {
+                string fileName = input.size() > 13 ? input.substr(13) : "csopesy-trace.json";
+                std::ofstream traceFile(fileName);
+                if (!traceFile) {
+                    printw("Unable to open %s\n", fileName.c_str());
+                } else {
+                    long long written = sim.exportTrace(traceFile);
+                    printw("Exported %lld trace events to %s\n", written, fileName.c_str());
+                }
+            } else if (input == "vmstat") {
+                ostringstream out;
+                sim.writeVmstat(out);
+                printw("%s", out.str().c_str());
+            } else if (input == "record-stop") {
+                sim.stopRecording();
+                printw("Recording stopped after %lld arrivals.\n", sim.num_recorded);
+            } else if (input.find("record") == 0) {
+                string fileName = input.size() > 7 ? input.substr(7) : "csopesy-workload.bin";
+                if (!sim.recordWorkload(fileName)) printw("Unable to open %s\n", fileName.c_str());
+                else printw("Recording arrivals to %s.\n", fileName.c_str());
+            } else if (input.find("replay") == 0) {
+                string fileName = input.size() > 7 ? input.substr(7) : "csopesy-workload.bin";
+                if (!sim.replayWorkload(fileName)) printw("Unable to replay %s, it is missing or not a workload trace\n", fileName.c_str());
+                else printw("Replaying %d arrivals from %s.\n", (int)sim.replayArrivals.size(), fileName.c_str());
+            } else if (input.find("checkpoint") == 0) {
+                string fileName = input.size() > 11 ? input.substr(11) : "csopesy-checkpoint.bin";
+                auto start = chrono::steady_clock::now();
+                if (!sim.checkpoint(fileName)) {
+                    printw("Unable to write %s\n", fileName.c_str());
+                } else {
+                    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                    printw("Checkpoint of tick %d written to %s in %.1f ms\n", sim.cpu_cycles, fileName.c_str(), ms);
+                }
+            } else if (input.find("restore") == 0) {
+                string fileName = input.size() > 8 ? input.substr(8) : "csopesy-checkpoint.bin";
+                auto start = chrono::steady_clock::now();
+                if (!sim.restore(fileName)) {
+                    printw("%s, nothing was restored\n", sim.error.c_str());
+                } else {
+                    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                    printw("Restored tick %d with %d processes from %s in %.1f ms\n", sim.cpu_cycles, sim.processes.size(), fileName.c_str(), ms);
+                }
+            }
+            else if (input == "exit") {
+                run = false;
+            }
+            else {
+                printw("Command not recognized. Please try again.\n");
+            }
+        }
+        refresh();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // usage: main --headless <ticks> [config file] [--restore <snapshot>] [--checkpoint <snapshot>]
+    //                                               [--replay <workload>] [--record <workload>]
+    if (argc >= 3 && string(argv[1]) == "--headless") {
+        long long ticks = atoll(argv[2]);
+        string configPath = "config.txt", restorePath, checkpointPath, replayPath, recordPath;
+        for (int i = 3; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--restore" && i + 1 < argc) restorePath = argv[++i];
+            else if (arg == "--checkpoint" && i + 1 < argc) checkpointPath = argv[++i];
+            else if (arg == "--replay" && i + 1 < argc) replayPath = argv[++i];
+            else if (arg == "--record" && i + 1 < argc) recordPath = argv[++i];
+            else configPath = arg;
+        }
+        return runHeadless(ticks, configPath, restorePath, checkpointPath, replayPath, recordPath);
+    }
+    // usage: main --sweep <ticks> <grid file> [base config file] [csv file]
+    if (argc >= 4 && string(argv[1]) == "--sweep") {
+        long long ticks = atoll(argv[2]);
+        return runSweep(ticks, argv[3], argc >= 5 ? argv[4] : "config.txt", argc >= 6 ? argv[5] : "csopesy-sweep.csv");
+    }
+
+    initscr();
+    start_color();
+    scrollok(stdscr, TRUE);
+    init_pair(1, COLOR_WHITE, COLOR_BLACK);
+    init_pair(2, COLOR_YELLOW, COLOR_BLACK);
+    init_pair(3, COLOR_GREEN, COLOR_BLACK);
+    cbreak();
+    mainMenu();
+    refresh();
+    endwin();
+
+    // stop the simulation threads so nothing is waiting on a condition variable during teardown
+    sim.stop();
+    sim.stopBSThread();
+    return 0;
+}
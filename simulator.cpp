@@ -0,0 +1,2762 @@
+#include "simulator.h"
+#include <ctime>
+#include <climits>
+#include <iomanip>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+thread_local int Simulator::traceRing = 0;
+
+// snapshot encoding: native-endian fixed-size values, vectors and strings prefixed by their length
+// everything is appended to one buffer so a checkpoint is a single write
+struct SnapshotWriter {
+    string buf;
+    template <typename T> void put(const T& v) { buf.append((const char*)&v, sizeof(T)); }
+    template <typename T> void putVec(const vector<T>& v) {
+        put<uint64_t>(v.size());
+        buf.append((const char*)v.data(), v.size() * sizeof(T));
+    }
+    void putStr(const string& str) {
+        put<uint64_t>(str.size());
+        buf += str;
+    }
+};
+
+// reads what SnapshotWriter wrote, ok turns false instead of reading past the end
+struct SnapshotReader {
+    const char* p;
+    const char* end;
+    bool ok = true;
+    template <typename T> T get() {
+        T v{};
+        if (end - p < (ptrdiff_t)sizeof(T)) {
+            ok = false;
+            return v;
+        }
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+    template <typename T> void getVec(vector<T>& v) {
+        uint64_t n = get<uint64_t>();
+        if (!ok || n > (uint64_t)(end - p) / sizeof(T)) {
+            ok = false;
+            v.clear();
+            return;
+        }
+        v.resize(n);
+        memcpy(v.data(), p, n * sizeof(T));
+        p += n * sizeof(T);
+    }
+    string getStr() {
+        uint64_t n = get<uint64_t>();
+        if (!ok || n > (uint64_t)(end - p)) {
+            ok = false;
+            return "";
+        }
+        string str(p, n);
+        p += n;
+        return str;
+    }
+};
+
+void ReplacementPolicy::save(SnapshotWriter& w) { w.putVec(pinned); }
+void ReplacementPolicy::load(SnapshotReader& r) {
+    size_t frames = pinned.size();
+    r.getVec(pinned);
+    if (pinned.size() != frames) r.ok = false;
+}
+
+// doubly linked list of resident frames, head is evicted first
+// fifo keeps load order, lru moves a frame to the tail on every access
+class FrameListPolicy : public ReplacementPolicy {
+public:
+    FrameListPolicy(int frames, bool lru) : ReplacementPolicy(frames), prev(frames, -1), next(frames, -1), linked(frames, 0), lru(lru) {}
+    void onLoad(int frame) override { pushBack(frame); }
+    void onAccess(int frame) override {
+        if (lru && linked[frame]) {
+            unlink(frame);
+            pushBack(frame);
+        }
+    }
+    void onFree(int frame) override {
+        if (linked[frame]) unlink(frame);
+        pinned[frame] = 0;
+    }
+    int victim() override {
+        for (int f = head; f != -1; f = next[f]) {
+            if (!pinned[f]) return f;
+        }
+        return -1;
+    }
+    void save(SnapshotWriter& w) override {
+        ReplacementPolicy::save(w);
+        w.putVec(prev);
+        w.putVec(next);
+        w.putVec(linked);
+        w.put(head);
+        w.put(tail);
+    }
+    void load(SnapshotReader& r) override {
+        ReplacementPolicy::load(r);
+        r.getVec(prev);
+        r.getVec(next);
+        r.getVec(linked);
+        head = r.get<int>();
+        tail = r.get<int>();
+        if (prev.size() != pinned.size() || next.size() != pinned.size() || linked.size() != pinned.size()) r.ok = false;
+    }
+private:
+    vector<int> prev, next;
+    vector<char> linked;
+    int head = -1, tail = -1;
+    bool lru;
+    void pushBack(int frame) {
+        prev[frame] = tail;
+        next[frame] = -1;
+        if (tail != -1) next[tail] = frame;
+        else head = frame;
+        tail = frame;
+        linked[frame] = 1;
+    }
+    void unlink(int frame) {
+        if (prev[frame] != -1) next[prev[frame]] = next[frame];
+        else head = next[frame];
+        if (next[frame] != -1) prev[next[frame]] = prev[frame];
+        else tail = prev[frame];
+        linked[frame] = 0;
+    }
+};
+
+// clock / second chance, the hand clears reference bits until it finds an unreferenced frame
+class ClockPolicy : public ReplacementPolicy {
+public:
+    ClockPolicy(int frames) : ReplacementPolicy(frames), used(frames, 0), ref(frames, 0) {}
+    void onLoad(int frame) override { used[frame] = 1; ref[frame] = 1; }
+    void onAccess(int frame) override { ref[frame] = 1; }
+    void onFree(int frame) override { used[frame] = 0; ref[frame] = 0; pinned[frame] = 0; }
+    int victim() override {
+        int n = used.size();
+        // two sweeps are enough: the first clears every reference bit
+        for (int steps = 0; steps < 2 * n; steps++) {
+            int f = hand;
+            hand = (hand + 1) % n;
+            if (!used[f] || pinned[f]) continue;
+            if (ref[f]) {
+                ref[f] = 0;
+                continue;
+            }
+            return f;
+        }
+        return -1;
+    }
+    void save(SnapshotWriter& w) override {
+        ReplacementPolicy::save(w);
+        w.putVec(used);
+        w.putVec(ref);
+        w.put(hand);
+    }
+    void load(SnapshotReader& r) override {
+        ReplacementPolicy::load(r);
+        r.getVec(used);
+        r.getVec(ref);
+        hand = r.get<int>();
+        if (used.size() != pinned.size() || ref.size() != pinned.size() || hand < 0 || hand >= (int)max(used.size(), (size_t)1)) r.ok = false;
+    }
+private:
+    vector<char> used, ref;
+    int hand = 0;
+};
+
+// least frequently used, ties go to the least recently used
+class LFUPolicy : public ReplacementPolicy {
+public:
+    LFUPolicy(int frames) : ReplacementPolicy(frames), count(frames, 0), stamp(frames, 0), present(frames, 0) {}
+    void onLoad(int frame) override {
+        count[frame] = 1;
+        stamp[frame] = ++now;
+        present[frame] = 1;
+        order.insert({count[frame], stamp[frame], frame});
+    }
+    void onAccess(int frame) override {
+        if (!present[frame]) return;
+        order.erase({count[frame], stamp[frame], frame});
+        count[frame]++;
+        stamp[frame] = ++now;
+        order.insert({count[frame], stamp[frame], frame});
+    }
+    void onFree(int frame) override {
+        if (present[frame]) order.erase({count[frame], stamp[frame], frame});
+        present[frame] = 0;
+        pinned[frame] = 0;
+    }
+    int victim() override {
+        for (auto& [c, t, f] : order) {
+            if (!pinned[f]) return f;
+        }
+        return -1;
+    }
+    // the eviction order is rebuilt from the counts and stamps of present frames
+    void save(SnapshotWriter& w) override {
+        ReplacementPolicy::save(w);
+        w.putVec(count);
+        w.putVec(stamp);
+        w.putVec(present);
+        w.put(now);
+    }
+    void load(SnapshotReader& r) override {
+        ReplacementPolicy::load(r);
+        r.getVec(count);
+        r.getVec(stamp);
+        r.getVec(present);
+        now = r.get<long long>();
+        order.clear();
+        if (count.size() != pinned.size() || stamp.size() != pinned.size() || present.size() != pinned.size()) {
+            r.ok = false;
+            return;
+        }
+        for (int f = 0; f < (int)present.size(); f++) {
+            if (present[f]) order.insert({count[f], stamp[f], f});
+        }
+    }
+private:
+    vector<long long> count, stamp;
+    vector<char> present;
+    set<tuple<long long, long long, int>> order;
+    long long now = 0;
+};
+
+ReplacementPolicy* makeReplacementPolicy(const string& name, int frames) {
+    if (name == "lru") return new FrameListPolicy(frames, true);
+    if (name == "clock") return new ClockPolicy(frames);
+    if (name == "lfu") return new LFUPolicy(frames);
+    return new FrameListPolicy(frames, false); // fifo
+}
+
+// offline belady oracle: faults an optimal policy would take on refs with the given frames
+long long optFaults(const vector<long long>& refs, int frames) {
+    int n = refs.size();
+    vector<int> nextUse(n);
+    unordered_map<long long, int> seen;
+    for (int i = n - 1; i >= 0; i--) {
+        auto it = seen.find(refs[i]);
+        nextUse[i] = (it == seen.end() ? INT_MAX : it->second);
+        seen[refs[i]] = i;
+    }
+    long long faults = 0;
+    unordered_map<long long, int> resident; // page -> its next use
+    set<pair<int, long long>> byNextUse;   // evict the page used furthest in the future
+    for (int i = 0; i < n; i++) {
+        auto it = resident.find(refs[i]);
+        if (it != resident.end()) {
+            byNextUse.erase({it->second, refs[i]});
+        } else {
+            faults++;
+            if ((int)resident.size() == frames) {
+                auto last = prev(byNextUse.end());
+                resident.erase(last->second);
+                byNextUse.erase(last);
+            }
+        }
+        resident[refs[i]] = nextUse[i];
+        byNextUse.insert({nextUse[i], refs[i]});
+    }
+    return faults;
+}
+
+
+// function to get local time stamp
+// localtime's shared buffer isn't safe with several simulations creating processes at once
+string getTimeStamp() {
+    time_t now = time(0);
+    tm ltm;
+#ifdef _WIN32
+    localtime_s(&ltm, &now);
+#else
+    localtime_r(&now, &ltm);
+#endif
+    char buffer[80];
+    strftime(buffer, 80, "%m/%d/%Y, %I:%M:%S %p", &ltm);
+
+    return string(buffer);
+}
+
+ProcessScreen Simulator::getProcByPid(int pid) {
+    if (pid >= 0 && pid < processes.size() && processes[pid].pid != -1) {
+        return processes[pid];
+    }
+    ProcessScreen p = {-1, "", 0, 0, "", -1, 0, 0};
+    return p; 
+}
+
+// pid of the named process, -1 if there is none
+int Simulator::findProcess(const string& name) {
+    lock_guard<mutex> lk(procMtx);
+    auto it = processIndex.find(name);
+    return it == processIndex.end() ? -1 : it->second;
+}
+
+// append random instructions to prog that run exactly budget lines
+void generateBlock(vector<Instr>& prog, int budget, int depth, int vars, XorShift& rng) {
+    while (budget > 0) {
+        int op = rng.next() % (OP_FOR + 1);
+        // long stretches always become loops so programs stay small
+        if ((op == OP_FOR || budget > 64) && depth < MAX_LOOP_DEPTH && budget >= 4) {
+            int repeats = min(2 + (int)(rng.next() % 9), budget / 2);
+            int body = 1 + rng.next() % (budget / repeats);
+            int start = prog.size();
+            prog.push_back({OP_FOR, (uint8_t)depth, 0, 0, (uint32_t)repeats});
+            generateBlock(prog, body, depth + 1, vars, rng);
+            prog.push_back({OP_END, (uint8_t)depth, 0, 0, (uint32_t)start + 1});
+            budget -= repeats * body;
+            continue;
+        }
+        if (op == OP_FOR || (vars == 0 && op != OP_SLEEP)) op = OP_PRINT;
+        Instr in = {(uint8_t)op, 0, 0, 0, 0};
+        if (op == OP_DECLARE) {
+            in.dst = rng.next() % vars;
+            in.imm = rng.next() % 65536;
+        } else if (op == OP_ADD || op == OP_SUBTRACT) {
+            in.dst = rng.next() % vars;
+            in.a = rng.next() % vars;
+            in.b = rng.next() % vars;
+            // at most one immediate operand
+            if (rng.next() % 2) {
+                if (rng.next() % 2) in.a = VAR_IMM;
+                else in.b = VAR_IMM;
+                in.imm = rng.next() % 1024;
+            }
+        } else if (op == OP_SLEEP) {
+            in.imm = 1 + rng.next() % 4;
+        }
+        prog.push_back(in);
+        budget--;
+    }
+}
+
+// create a process with a random instruction count and memory size, -1 if the name is taken
+// an empty name generates "p<pid>", skipping names already used with screen -s
+int Simulator::addProcess(string name, const Arrival* arrival) {
+    lock_guard<mutex> lk(procMtx);
+    if (name == "") {
+        name = "p" + to_string(pid);
+        while (processIndex.find(name) != processIndex.end()) {
+            pid++;
+            name = "p" + to_string(pid);
+        }
+    } else if (processIndex.find(name) != processIndex.end()) {
+        return -1;
+    }
+    Arrival a;
+    if (arrival) {
+        a = *arrival;
+    } else {
+        a.mem = pow(2, rng.next() % (max_exp - min_exp + 1) + min_exp);
+        a.lines = rng.next() % (max_ins - min_ins + 1) + min_ins;
+        a.programSeed = rng.next() | 1;
+    }
+    if (workloadOut.is_open()) {
+        a.tick = cpu_cycles - recordStart;
+        workloadOut.write((const char*)&a, sizeof(a));
+        num_recorded++;
+    }
+    int M = a.mem;
+    ProcessScreen newScreen = { pid, name, 0, a.lines, getTimeStamp(), -1, M, M/mem_per_frame};
+    // the symbol table sits at the start of the process's memory, in page 0 when paging
+    newScreen.arrivalTick = cpu_cycles;
+    newScreen.firstDispatchTick = -1;
+    newScreen.completionTick = -1;
+    newScreen.vars = min(SYMTAB_WORDS, (flat ? M : (newScreen.pages > 0 ? min(M, mem_per_frame) : 0)) / 2);
+    newScreen.programSeed = a.programSeed;
+    processes.add(newScreen);
+    processIndex[name] = pid;
+    loadProgram(pid);
+    return pid++;
+}
+
+// the same seed always generates the same program
+void Simulator::loadProgram(int pid) {
+    ProcessScreen& p = processes[pid];
+    vector<Instr> program;
+    XorShift programRng = {p.programSeed | 1};
+    generateBlock(program, p.totalLines, 0, p.vars, programRng);
+    lock_guard<mutex> lk(programMtx);
+    vector<Instr>& owned = programs[pid] = move(program);
+    p.code = owned.data();
+    p.codeSize = owned.size();
+}
+
+void Simulator::pushRunQueue(int q, int pid) {
+    processes[pid].readySince = cpu_cycles;
+    lock_guard<mutex> lk(runQueues[q].mtx);
+    runQueues[q].levels[processes[pid].level].push_back(pid);
+    runQueues[q].length++;
+}
+
+// puts a process that couldn't be dispatched back at the head of its level
+void Simulator::pushRunQueueFront(int q, int pid) {
+    lock_guard<mutex> lk(runQueues[q].mtx);
+    runQueues[q].levels[processes[pid].level].push_front(pid);
+    runQueues[q].length++;
+}
+
+// pops the next pid of queue q in priority order, -1 if there is none to take
+// the first dispatch-scan entries are checked for one that fits without eviction, if none does the head
+// is taken unless fitOnly. the head is passed over at most dispatch-scan times in a row so it can't starve
+int Simulator::popRunQueue(int q, bool fitOnly) {
+    RunQueue& rq = runQueues[q];
+    lock_guard<mutex> lk(rq.mtx);
+    deque<int>* head = nullptr;
+    for (auto& level : rq.levels) {
+        if (!level.empty()) {
+            head = &level;
+            break;
+        }
+    }
+    if (head == nullptr) return -1;
+    int window = rq.bypassed < dispatch_scan ? dispatch_scan : 1;
+    int scanned = 0;
+    for (auto& level : rq.levels) {
+        for (auto it = level.begin(); it != level.end() && scanned < window; ++it, scanned++) {
+            if (processes[*it].sleepUntil > cpu_cycles || !fitsWithoutEviction(*it)) continue;
+            int p = *it;
+            if (&level == head && it == level.begin()) {
+                rq.bypassed = 0;
+            } else {
+                rq.bypassed++;
+                num_dispatch_ahead++;
+            }
+            level.erase(it);
+            rq.length--;
+            return p;
+        }
+    }
+    if (fitOnly || processes[head->front()].sleepUntil > cpu_cycles) return -1;
+    int p = head->front();
+    head->pop_front();
+    rq.length--;
+    rq.bypassed = 0;
+    return p;
+}
+
+// new processes go to the shortest queue, ties broken round robin so a burst spreads out
+void Simulator::submitProcess(int pid) {
+    if (pid == -1) return;
+    int n = runQueues.size();
+    int start = nextSubmit.fetch_add(1) % n;
+    int best = start;
+    for (int i = 1; i < n; i++) {
+        int q = (start + i) % n;
+        if (runQueues[q].length < runQueues[best].length) best = q;
+    }
+    trace(TR_ARRIVE, pid, best);
+    pushRunQueue(best, pid);
+}
+
+// next process for a core: its own queue first, otherwise steal from the longest one
+int Simulator::takeProcess(int cpu, bool fitOnly) {
+    int p = popRunQueue(cpu, fitOnly);
+    if (p != -1) return p;
+    int victim = -1;
+    for (int q = 0; q < (int)runQueues.size(); q++) {
+        if (runQueues[q].length > 0 && (victim == -1 || runQueues[q].length > runQueues[victim].length)) victim = q;
+    }
+    if (victim == -1) return -1;
+    p = popRunQueue(victim, fitOnly);
+    if (p != -1) num_steals++;
+    return p;
+}
+
+// moves work from the longest queue to the shortest until they differ by at most one
+void Simulator::balanceRunQueues() {
+    int n = runQueues.size();
+    for (int moves = 0; moves < n; moves++) {
+        int longest = 0, shortest = 0;
+        for (int q = 1; q < n; q++) {
+            if (runQueues[q].length > runQueues[longest].length) longest = q;
+            if (runQueues[q].length < runQueues[shortest].length) shortest = q;
+        }
+        if (runQueues[longest].length - runQueues[shortest].length <= 1) return;
+        scoped_lock lk(runQueues[longest].mtx, runQueues[shortest].mtx);
+        // the newest arrival of the lowest level moves so the longest queue keeps its order
+        auto& levels = runQueues[longest].levels;
+        int l = levels.size() - 1;
+        while (l >= 0 && levels[l].empty()) l--;
+        if (l < 0) return;
+        runQueues[shortest].levels[l].push_back(levels[l].back());
+        levels[l].pop_back();
+        runQueues[longest].length--;
+        runQueues[shortest].length++;
+        num_balance_moves++;
+    }
+}
+
+int Simulator::runQueueLength() {
+    int total = 0;
+    for (auto& q : runQueues) total += q.length;
+    return total;
+}
+
+// remove a free block from both indexes, caller holds flatMtx
+void Simulator::eraseFreeBlock(map<int, MemoryBlock>::iterator it) {
+    freeBySize.erase({it->second.mem, it->second.start});
+    freeMem.erase(it);
+}
+
+// add a free block, merging it with the blocks right before and after it in O(log n)
+// caller holds flatMtx
+void Simulator::insertFreeBlock(int start, int end) {
+    auto next = freeMem.lower_bound(start);
+    if (next != freeMem.end() && next->second.start == end + 1) {
+        end = next->second.end;
+        eraseFreeBlock(next);
+    }
+    auto after = freeMem.lower_bound(start);
+    if (after != freeMem.begin()) {
+        auto before = std::prev(after);
+        if (before->second.end + 1 == start) {
+            start = before->second.start;
+            eraseFreeBlock(before);
+        }
+    }
+    MemoryBlock m = {start, end, -1, end - start + 1, 0, 0};
+    freeMem[start] = m;
+    freeBySize.insert({m.mem, start});
+}
+
+// pick a free block of at least mem using fit_policy, freeMem.end() if none, caller holds flatMtx
+map<int, MemoryBlock>::iterator Simulator::findFreeBlock(int mem) {
+    if (fit_policy == "best-fit") {
+        auto it = freeBySize.lower_bound({mem, INT_MIN});
+        return it == freeBySize.end() ? freeMem.end() : freeMem.find(it->second);
+    }
+    if (fit_policy == "worst-fit") {
+        if (freeBySize.empty() || freeBySize.rbegin()->first < mem) return freeMem.end();
+        return freeMem.find(freeBySize.rbegin()->second);
+    }
+    // no block is big enough, skip the address-order walk
+    if (freeBySize.empty() || freeBySize.rbegin()->first < mem) return freeMem.end();
+    if (fit_policy == "next-fit") {
+        // resume from where the last allocation ended, then wrap around
+        auto start = freeMem.lower_bound(nextFitStart);
+        if (start != freeMem.begin() && std::prev(start)->second.end >= nextFitStart) start--;
+        for (auto it = start; it != freeMem.end(); ++it) {
+            if (it->second.mem >= mem) return it;
+        }
+        for (auto it = freeMem.begin(); it != start; ++it) {
+            if (it->second.mem >= mem) return it;
+        }
+        return freeMem.end();
+    }
+    // first-fit, lowest address that fits
+    for (auto it = freeMem.begin(); it != freeMem.end(); ++it) {
+        if (it->second.mem >= mem) return it;
+    }
+    return freeMem.end();
+}
+
+// smallest order whose block holds mem
+int Simulator::buddyOrder(int mem) {
+    int order = 0;
+    while ((1 << order) < mem) order++;
+    return order;
+}
+
+// seed the buddy free lists with the largest aligned power-of-two blocks that fit in max_overall_mem
+void Simulator::initBuddy() {
+    buddyMaxOrder = 0;
+    while ((2LL << buddyMaxOrder) <= max_overall_mem) buddyMaxOrder++;
+    buddyFree.assign(buddyMaxOrder + 1, set<int>());
+    int start = 0;
+    for (int order = buddyMaxOrder; order >= 0; order--) {
+        if (start + (1 << order) <= max_overall_mem) {
+            buddyFree[order].insert(start);
+            start += 1 << order;
+        }
+    }
+}
+
+// take a 2^order block, splitting a larger one if needed, -1 if none, caller holds flatMtx
+int Simulator::buddyAlloc(int order) {
+    int j = order;
+    while (j <= buddyMaxOrder && buddyFree[j].empty()) j++;
+    if (j > buddyMaxOrder) return -1;
+    int start = *buddyFree[j].begin();
+    buddyFree[j].erase(buddyFree[j].begin());
+    // keep the lower half, give the upper half back at each level
+    while (j > order) {
+        j--;
+        buddyFree[j].insert(start + (1 << j));
+    }
+    return start;
+}
+
+// give back a 2^order block, merging with its buddy while the buddy is free, caller holds flatMtx
+void Simulator::buddyRelease(int start, int order) {
+    while (order < buddyMaxOrder) {
+        int mate = start ^ (1 << order);
+        auto it = buddyFree[order].find(mate);
+        if (it == buddyFree[order].end()) break;
+        buddyFree[order].erase(it);
+        start = min(start, mate);
+        order++;
+    }
+    buddyFree[order].insert(start);
+}
+
+// move a taken block back to the free blocks, caller holds flatMtx
+void Simulator::freeTakenBlock(list<MemoryBlock>::iterator it) {
+    if (buddy) buddyRelease(it->start, buddyOrder(it->end - it->start + 1));
+    else insertFreeBlock(it->start, it->end);
+    takenByPid.erase(it->pid);
+    takenMem.erase(it);
+}
+
+
+// backing store: one preallocated swap file mapped into memory and split into fixed-size slots
+// a slot bitmap finds free slots and each pid keeps a stack of its slots, so swapping is a memory copy
+struct SwapSlot {
+    int pid;
+    int tick;       // cpu_cycles when it was swapped out
+    char data[56];  // symbol table of a process that left memory
+};
+static_assert(sizeof(SwapSlot::data) == SYMTAB_WORDS * sizeof(uint16_t), "a symbol table fills one swap slot");
+
+// (re)map the swap file at the given number of slots, caller holds bsMtx
+bool Simulator::mapSwapFile(size_t slots) {
+    size_t bytes = slots * sizeof(SwapSlot);
+#ifdef _WIN32
+    if (swapMap) UnmapViewOfFile(swapMap);
+    if (swapMapping) CloseHandle(swapMapping);
+    swapMapping = CreateFileMappingA(swapFile, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)bytes >> 32), (DWORD)bytes, NULL);
+    if (!swapMapping) return false;
+    swapMap = (SwapSlot*)MapViewOfFile(swapMapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!swapMap) return false;
+#else
+    if (swapMap) munmap(swapMap, swapCapacity * sizeof(SwapSlot));
+    if (ftruncate(swapFd, bytes) != 0) return false;
+    void* m = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, swapFd, 0);
+    if (m == MAP_FAILED) {
+        swapMap = nullptr;
+        return false;
+    }
+    swapMap = (SwapSlot*)m;
+#endif
+    swapCapacity = slots;
+    swapBitmap.resize((slots + 63) / 64, 0);
+    return true;
+}
+
+// truncate and map the swap file, replaces wiping backing_store/ file by file
+// the directory is created if it is missing, false if the file still can't be opened or mapped
+bool Simulator::initSwap() {
+    lock_guard<mutex> lk(bsMtx);
+    size_t slash = swapPath.find_last_of("/\\");
+    string dir = slash == string::npos ? "" : swapPath.substr(0, slash);
+#ifdef _WIN32
+    if (swapMap) UnmapViewOfFile(swapMap);
+    if (swapMapping) CloseHandle(swapMapping);
+    if (swapFile != INVALID_HANDLE_VALUE) CloseHandle(swapFile);
+    swapMap = nullptr;
+    swapMapping = NULL;
+    if (dir != "") CreateDirectoryA(dir.c_str(), NULL);
+    swapFile = CreateFileA(swapPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+#else
+    if (swapMap) munmap(swapMap, swapCapacity * sizeof(SwapSlot));
+    if (swapFd != -1) close(swapFd);
+    swapMap = nullptr;
+    if (dir != "") mkdir(dir.c_str(), 0755);
+    swapFd = open(swapPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+#endif
+    swapCapacity = 0;
+    swapUsed = 0;
+    swapHint = 0;
+    swapBitmap.clear();
+    swapSlotsByPid.clear();
+    swapImageSlot.clear();
+    return mapSwapFile(max(swap_slots, 64));
+}
+
+// claim a free slot, growing the file when all are taken, -1 if the file can't grow
+// caller holds bsMtx
+int Simulator::allocSwapSlot() {
+    if (swapUsed == swapCapacity && !mapSwapFile(swapCapacity * 2)) return -1;
+    size_t words = swapBitmap.size();
+    for (size_t n = 0; n < words; n++) {
+        size_t w = (swapHint + n) % words;
+        if (~swapBitmap[w] == 0) continue;
+        int bit = __builtin_ctzll(~swapBitmap[w]);
+        size_t slot = w * 64 + bit;
+        if (slot >= swapCapacity) continue;
+        swapBitmap[w] |= 1ULL << bit;
+        swapHint = w;
+        swapUsed++;
+        return slot;
+    }
+    return -1;
+}
+
+// caller holds bsMtx
+void Simulator::freeSwapSlot(int slot) {
+    swapBitmap[slot / 64] &= ~(1ULL << (slot % 64));
+    swapUsed--;
+}
+
+// write a slot for pid, caller holds bsMtx
+void Simulator::swapOut(int pid, int tick) {
+    int slot = allocSwapSlot();
+    if (slot == -1) return;
+    SwapSlot record = {};
+    record.pid = pid;
+    record.tick = tick;
+    memcpy(&swapMap[slot], &record, sizeof(SwapSlot));
+    swapSlotsByPid[pid].push_back(slot);
+}
+
+// read back and free pid's last slot, caller holds bsMtx
+void Simulator::swapIn(int pid) {
+    auto it = swapSlotsByPid.find(pid);
+    if (it == swapSlotsByPid.end() || it->second.empty()) return;
+    int slot = it->second.back();
+    it->second.pop_back();
+    // the slot only records that pid went out, its symbol table travels through storeImage and loadImage,
+    // so nothing is read back and swapping in costs the bookkeeping alone
+    freeSwapSlot(slot);
+}
+
+// free every slot of pid, caller holds bsMtx
+void Simulator::swapDrop(int pid) {
+    auto image = swapImageSlot.find(pid);
+    if (image != swapImageSlot.end()) {
+        freeSwapSlot(image->second);
+        swapImageSlot.erase(image);
+    }
+    auto it = swapSlotsByPid.find(pid);
+    if (it == swapSlotsByPid.end()) return;
+    for (int slot : it->second) freeSwapSlot(slot);
+    swapSlotsByPid.erase(it);
+}
+
+// symbol tables go straight to the swap file instead of through the write-behind queue below,
+// the next dispatch of the process has to read them back before it can run anyway
+void Simulator::storeImage(int pid, const uint16_t* image, int words) {
+    lock_guard<mutex> lk(bsMtx);
+    auto it = swapImageSlot.find(pid);
+    int slot = it != swapImageSlot.end() ? it->second : allocSwapSlot();
+    if (slot == -1) return;
+    swapImageSlot[pid] = slot;
+    swapMap[slot].pid = pid;
+    swapMap[slot].tick = cpu_cycles;
+    memcpy(swapMap[slot].data, image, words * sizeof(uint16_t));
+}
+
+// read pid's symbol table back and free its slot, false if it has none
+bool Simulator::loadImage(int pid, uint16_t* image, int words) {
+    lock_guard<mutex> lk(bsMtx);
+    auto it = swapImageSlot.find(pid);
+    if (it == swapImageSlot.end()) return false;
+    memcpy(image, swapMap[it->second].data, words * sizeof(uint16_t));
+    freeSwapSlot(it->second);
+    swapImageSlot.erase(it);
+    return true;
+}
+
+void Simulator::bsThread() {
+    vector<BSOp> batch;
+    while (true) {
+        {
+            unique_lock<mutex> lk(bsQueueMtx);
+            bsWorkCv.wait(lk, [this] { return !bsQueue.empty() || bsStop; });
+            if (bsQueue.empty()) return;
+            batch.assign(bsQueue.begin(), bsQueue.end());
+            bsQueue.clear();
+            // stores leave the write-behind buffer here, unless a swap-in already took them
+            for (auto& op : batch) {
+                if (op.type != BS_STORE) continue;
+                int& cancelled = bsCancelledStores[op.pid];
+                if (cancelled > 0) {
+                    cancelled--;
+                    op.skip = true;
+                } else {
+                    bsPendingStores[op.pid]--;
+                }
+            }
+            bsBusy = true;
+            bsSpaceCv.notify_all();
+        }
+
+        bsMtx.lock();
+        for (auto& op : batch) {
+            if (op.skip) continue;
+            if (op.type == BS_STORE) swapOut(op.pid, op.tick);
+            else if (op.type == BS_RETRIEVE) swapIn(op.pid);
+            else swapDrop(op.pid);
+        }
+        bsMtx.unlock();
+
+        auto done = chrono::steady_clock::now();
+        lock_guard<mutex> lk(bsQueueMtx);
+        for (auto& op : batch) {
+            bs_latency_us += chrono::duration<double, micro>(done - op.queued).count();
+        }
+        bs_ops_done += batch.size();
+        bs_batches++;
+        bsBusy = false;
+        if (bsQueue.empty()) bsIdleCv.notify_all();
+    }
+}
+
+// queue a request, waiting for room if the queue is full, caller holds lk on bsQueueMtx
+void Simulator::bsEnqueue(unique_lock<mutex>& lk, BSOpType type, int pid) {
+    if ((int)bsQueue.size() >= bs_queue_depth) {
+        bs_stalls++;
+        bsSpaceCv.wait(lk, [this] { return (int)bsQueue.size() < bs_queue_depth; });
+    }
+    bsQueue.push_back({type, pid, cpu_cycles, chrono::steady_clock::now(), false});
+    bs_max_depth = max(bs_max_depth, bsQueue.size());
+    // a busy I/O thread looks at the queue again before it waits
+    if (bsQueue.size() == 1) bsWorkCv.notify_one();
+}
+
+// add item to backing store
+void Simulator::BSStore(int pid) {
+    if (pid == -1) return;
+    unique_lock<mutex> lk(bsQueueMtx);
+    bsPendingStores[pid]++;
+    bsStoredCount[pid]++;
+    bsEnqueue(lk, BS_STORE, pid);
+}
+
+// remove item from backing store if exists
+void Simulator::BSRetrieve(int pid) {
+    if (pid == -1) return;
+    unique_lock<mutex> lk(bsQueueMtx);
+    auto stored = bsStoredCount.find(pid);
+    if (stored == bsStoredCount.end() || stored->second == 0) return; // nothing to swap in
+    stored->second--;
+    auto it = bsPendingStores.find(pid);
+    if (it != bsPendingStores.end() && it->second > 0) {
+        // still in the write-behind buffer, take it back without touching the swap file
+        it->second--;
+        bsCancelledStores[pid]++;
+        bs_coalesced++;
+        return;
+    }
+    bsEnqueue(lk, BS_RETRIEVE, pid);
+}
+
+// remove everything a process has in the backing store
+void Simulator::BSClear(int pid) {
+    unique_lock<mutex> lk(bsQueueMtx);
+    if (bsStoredCount.erase(pid) == 0) return; // never swapped out
+    auto it = bsPendingStores.find(pid);
+    if (it != bsPendingStores.end()) {
+        // queued stores for pid would only be freed again
+        bsCancelledStores[pid] += it->second;
+        bs_coalesced += it->second;
+        bsPendingStores.erase(it);
+    }
+    bsEnqueue(lk, BS_CLEAR, pid);
+}
+
+// wait until every queued request has been applied
+void Simulator::BSFlush() {
+    unique_lock<mutex> lk(bsQueueMtx);
+    bsIdleCv.wait(lk, [this] { return bsQueue.empty() && !bsBusy; });
+}
+
+void Simulator::startBSThread() {
+    if (bsWorker.joinable()) return;
+    bsWorker = thread(&Simulator::bsThread, this);
+}
+
+// apply what is still queued and let the I/O thread exit
+void Simulator::stopBSThread() {
+    if (!bsWorker.joinable()) return;
+    bsQueueMtx.lock();
+    bsStop = true;
+    bsWorkCv.notify_one();
+    bsQueueMtx.unlock();
+    bsWorker.join();
+}
+
+// move a process's block from takenMem back to freeMem, returns 0 if it had none
+// frees pid's block, copying its symbol table to image first unless image is null
+bool Simulator::FlatRelease(int pid, uint16_t* image) {
+    lock_guard<mutex> lk(flatMtx);
+    auto it = takenByPid.find(pid);
+    if (it == takenByPid.end()) return 0;
+    if (image) memcpy(image, &physMem[it->second->start / 2], processes[pid].vars * sizeof(uint16_t));
+    freeTakenBlock(it->second);
+    return 1;
+}
+
+// return a frame to the free list and unmap it from its owner's page table
+// caller holds the frame's region lock
+void Simulator::freeFrame(int key) {
+    PIDAge& value = frameMap[key];
+    if (value.pid != -1) {
+        lock_guard<mutex> lk(pageTableMtx);
+        auto it = pageTables.find(value.pid);
+        if (it != pageTables.end() && it->second.frames[value.page] == key) {
+            it->second.frames[value.page] = -1;
+            it->second.resident--;
+        }
+    }
+    value.active = 0;
+    value.pid = -1;
+    value.page = -1;
+    policyMtx.lock();
+    replacementPolicy->onFree(key);
+    policyMtx.unlock();
+    lock_guard<mutex> lk(freeFrameMtx);
+    freeFrameList.push_back(key);
+}
+
+// frames currently held by a process, O(pages of pid)
+vector<int> Simulator::residentFrames(int pid) {
+    vector<int> frames;
+    lock_guard<mutex> lk(pageTableMtx);
+    auto it = pageTables.find(pid);
+    if (it == pageTables.end()) return frames;
+    for (int f : it->second.frames) {
+        if (f != -1) frames.push_back(f);
+    }
+    return frames;
+}
+
+// free every frame held by a process
+void Simulator::PageRelease(int pid) {
+    for (int key : residentFrames(pid)) {
+        lock_guard<mutex> lk(frameRegionMtx[key / FRAME_REGION_SIZE]);
+        if (frameMap[key].pid == pid) freeFrame(key);
+    }
+}
+
+void Simulator::FlatDealloc(int pid) {
+    FlatRelease(pid, nullptr);
+    // remove from backing store
+    BSClear(pid);
+}
+
+void Simulator::PageDealloc(int pid) {
+    // dealloc all pages from frame map
+    PageRelease(pid);
+    pageTableMtx.lock();
+    pageTables.erase(pid);
+    pageTableMtx.unlock();
+    // remove from backing store
+    BSClear(pid);
+}
+
+
+// scheduling policy, the clock calls tick() once per tick to hand idle cores work
+// cores ask it how far one execution advances a process and whether they give it up afterwards
+class Scheduler {
+public:
+    Scheduler(Simulator& sim) : sim(sim) {}
+    virtual ~Scheduler() {}
+    virtual void tick() = 0;               // dispatch idle cores, called once per clock tick
+    virtual int linesPerExec(int pid) = 0; // lines one execution of pid runs
+    virtual bool releaseAfterExec() = 0;   // core gives its process back after every execution
+    virtual void onSliceEnd(int pid) {}    // pid used its whole slice without finishing
+protected:
+    Simulator& sim;
+};
+
+// true if the core is due for another execution at the current cpu_cycles
+// a core executes once every (delay_per_exec + 1) ticks
+bool Simulator::coreDue(int& numActualExecs) {
+    int eligible = (cpu_cycles + delay_per_exec) / (delay_per_exec + 1); // ceil without float drift
+    if (eligible >= numActualExecs) {
+        numActualExecs++;
+        return true;
+    }
+    return false;
+}
+
+// page holding instruction pc, the program follows the symbol table and wraps around the address space
+int Simulator::codePage(const ProcessScreen& p, int pc) {
+    long long addr = p.vars * sizeof(uint16_t) + (long long)pc * sizeof(Instr);
+    return addr % ((long long)p.pages * mem_per_frame) / mem_per_frame;
+}
+
+// frame of p's page through the core's tlb, walking the page table on a miss, -1 if not resident
+int translate(TLB* tlb, const int* frames, ProcessScreen& p, int page) {
+    if (!tlb) return frames[page];
+    int frame = tlb->lookup(p.pid, page);
+    if (frame != -1) {
+        tlb->hits++;
+        p.tlbHits++;
+        return frame;
+    }
+    tlb->misses++;
+    p.tlbMisses++;
+    frame = frames[page];
+    if (frame != -1) tlb->insert(p.pid, page, frame);
+    return frame;
+}
+
+// run up to lines lines of p's program against its symbol table in memory, returns how many ran
+// stops early at a SLEEP or the end of the program
+// with paging, frames is p's page table and every instruction fetch (and page 0 for variables) is translated
+// through tlb and must be resident, otherwise it stops before the instruction and sets faultPage
+int Simulator::interpret(ProcessScreen& p, int lines, const int* frames, TLB* tlb, int& faultPage) {
+    const Instr* code = p.code;
+    int end = p.codeSize;
+    uint16_t* vars = physMem.data() + p.base / 2;
+    int pc = p.pc;
+    int ran = 0;
+    int lastPage = -1;
+    bool varsTouched = false;
+    while (ran < lines && pc < end) {
+        const Instr& in = code[pc];
+        if (frames) {
+            int page = codePage(p, pc);
+            int frame = translate(tlb, frames, p, page);
+            if (frame == -1) {
+                faultPage = page;
+                break;
+            }
+            if (page != lastPage) {
+                touchPage(p.pid, page, frame);
+                lastPage = page;
+            }
+            if (in.op == OP_DECLARE || in.op == OP_ADD || in.op == OP_SUBTRACT) {
+                int varFrame = translate(tlb, frames, p, 0);
+                if (varFrame == -1) {
+                    faultPage = 0;
+                    break;
+                }
+                if (!varsTouched && page != 0) touchPage(p.pid, 0, varFrame);
+                varsTouched = true;
+            }
+        }
+        switch (in.op) {
+        case OP_PRINT:
+            p.prints++;
+            break;
+        case OP_DECLARE:
+            vars[in.dst] = min(in.imm, 65535u);
+            break;
+        case OP_ADD:
+        case OP_SUBTRACT: {
+            // uint16 arithmetic, clamped instead of wrapping
+            int a = in.a == VAR_IMM ? in.imm : vars[in.a];
+            int b = in.b == VAR_IMM ? in.imm : vars[in.b];
+            int r = in.op == OP_ADD ? a + b : a - b;
+            vars[in.dst] = r < 0 ? 0 : (r > 65535 ? 65535 : r);
+            break;
+        }
+        case OP_SLEEP:
+            p.sleepUntil = cpu_cycles + in.imm;
+            p.pc = pc + 1;
+            return ran + 1;
+        case OP_FOR:
+            p.loopLeft[in.dst] = in.imm;
+            pc++;
+            continue;
+        case OP_END:
+            pc = --p.loopLeft[in.dst] > 0 ? in.imm : pc + 1;
+            continue;
+        }
+        pc++;
+        ran++;
+    }
+    p.pc = pc;
+    return ran;
+}
+
+// one execution of a core: advance its process and release it if needed
+void Simulator::coreStep(int cpu) {
+    if (coreProcesses[cpu].flagCounter > 0) {
+        CoreProcess& cp = coreProcesses[cpu];
+        // waiting for a major fault, the process keeps the core
+        if (cpu_cycles < cp.stallUntil) return;
+        int pid = cp.pid;
+        ProcessScreen& p = processes[pid];
+        int lines = cp.sliceLeft > 0 ? cp.sliceLeft : schedulerPolicy->linesPerExec(pid);
+        cp.sliceLeft = 0;
+        const int* frames = nullptr;
+        TLB* tlb = nullptr;
+        if (flat == 0 && p.pages > 0) {
+            // the node doesn't move and only this core changes a running process's entries
+            lock_guard<mutex> lk(pageTableMtx);
+            PageTable& table = pageTables[pid];
+            frames = table.frames.data();
+            if (tlb_entries > 0) {
+                table.tlbCores |= 1ULL << (cpu % 64);
+                tlb = &tlbs[cpu];
+                tlb->applyShootdowns();
+            }
+        }
+        // a sleeping process holds on to (fcfs) or gives back (rr) its core without running
+        int ran = 0;
+        bool noFrame = false;
+        while (cpu_cycles >= p.sleepUntil) {
+            int faultPage = -1;
+            ran += interpret(p, lines - ran, frames, tlb, faultPage);
+            if (faultPage == -1) break;
+            int major = pageFault(pid, faultPage);
+            // nothing could be evicted, the process gives up the rest of its slice
+            if (major == -1) {
+                noFrame = true;
+                break;
+            }
+            if (major == 1 && page_fault_ticks > 0) {
+                // the rest of the slice runs once the page has been read
+                cp.stallUntil = cpu_cycles + page_fault_ticks;
+                cp.sliceLeft = lines - ran;
+                break;
+            }
+        }
+        p.currentLine += ran;
+        coreInstrs[cpu] += ran;
+        if (cp.sliceLeft > 0) return;
+
+        // check if complete
+        if (p.currentLine >= p.totalLines) {
+            p.completionTick = cpu_cycles;
+            turnaroundHist.add(p.completionTick - p.arrivalTick);
+            waitingHist.add(p.waitTicks);
+            trace(TR_FINISH, pid, cpu);
+            if (flat == 1) FlatDealloc(pid);
+            else PageDealloc(pid);
+            programMtx.lock();
+            programs.erase(pid);
+            programMtx.unlock();
+            coreProcesses[cpu].flagCounter = 0;
+            return;
+        }
+
+        // a process that keeps its core (fcfs) would sit on its pinned frames waiting for a free one,
+        // and with every core doing the same nothing runs. it unpins them and waits at the front of its queue
+        if (noFrame && !schedulerPolicy->releaseAfterExec()) {
+            trace(TR_PREEMPT, pid, cpu);
+            ActivatePages(pid, false);
+            cp.pid = -1;
+            cp.flagCounter = 0;
+            p.readySince = cpu_cycles;
+            pushRunQueueFront(cpu, pid);
+            return;
+        }
+
+        // only proper executions will count towards quantum slice counter
+        if (schedulerPolicy->releaseAfterExec()) {
+            if (ran == lines) schedulerPolicy->onSliceEnd(pid);
+            trace(TR_PREEMPT, pid, cpu);
+            if (flat == 1) {
+                // swap out to backing store after the block is released, not while holding flatMtx
+                uint16_t image[SYMTAB_WORDS];
+                if (FlatRelease(pid, image)) {
+                    trace(TR_PAGE_OUT, pid, -1);
+                    storeImage(pid, image, p.vars);
+                    BSStore(pid);
+                }
+            } else {
+                // pages stay resident but can be evicted while the process waits
+                ActivatePages(pid, false);
+            }
+            coreProcesses[cpu].flagCounter = 0; // change to -- if need slow
+        }
+    }
+}
+
+// function for each CORE
+// blocks until the clock hands it an execution, so idle cores cost no host cpu
+void Simulator::core(int cpu) {
+    traceRing = cpu + 2;
+    while (true) {
+        unique_lock<mutex> lk(coreMtx);
+        coreCv[cpu].wait(lk, [this, cpu] { return coreWork[cpu] == 1 || coreStop; });
+        if (coreWork[cpu] == 0) return;
+        lk.unlock();
+
+        coreStep(cpu);
+
+        lk.lock();
+        coreWork[cpu] = 0;
+        if (--pendingCores == 0) clockCv.notify_one();
+    }
+}
+
+// hand this tick's executions to every busy core that is due and wait for them to finish
+void Simulator::signalCores() {
+    unique_lock<mutex> lk(coreMtx);
+    for (int i = 0; i < num_cpu; i++) {
+        // idle cores still consume their slot so they stay in sync with cpu_cycles
+        if (coreDue(coreExecs[i]) && coreProcesses[i].flagCounter > 0) {
+            coreWork[i] = 1;
+            pendingCores++;
+            coreCv[i].notify_one();
+        }
+    }
+    clockCv.wait(lk, [this] { return pendingCores == 0; });
+}
+
+
+// loads config.txt values onto the simulator, false if one is out of range
+bool Simulator::initializeProgram(istream& configFile) {
+    SimConfig c = *this;
+    std::string line;
+    while (std::getline(configFile, line)) {
+        std::istringstream iss(line);
+        std::string key;
+
+        if (iss >> key) {
+            if (key == "num-cpu") {
+                iss >> c.num_cpu;
+            }
+            else if (key == "scheduler") {
+                iss >> c.scheduler;
+                // Remove the surrounding double quotes from the scheduler
+                if (!c.scheduler.empty() && c.scheduler[0] == '"') {
+                    c.scheduler = c.scheduler.substr(1, c.scheduler.size() - 2);
+                }
+            }
+            else if (key == "quantum-cycles") {
+                iss >> c.quantum_cycles;
+            }
+            else if (key == "batch-process-freq") {
+                iss >> c.batch_process_freq;
+            }
+            else if (key == "min-ins") {
+                iss >> c.min_ins;
+            }
+            else if (key == "max-ins") {
+                iss >> c.max_ins;
+            }
+            else if (key == "delay-per-exec") {
+                iss >> c.delay_per_exec;
+            }
+            else if (key == "max-overall-mem") {
+                iss >> c.max_overall_mem;
+            }
+            else if (key == "mem-per-frame") {
+                iss >> c.mem_per_frame;
+            }
+            else if (key == "min-mem-per-proc") {
+                iss >> c.min_mem_per_proc;
+            } 
+            else if (key == "max-mem-per-proc") {
+                iss >> c.max_mem_per_proc;
+            }
+            else if (key == "page-replacement") {
+                iss >> c.page_replacement;
+                if (!c.page_replacement.empty() && c.page_replacement[0] == '"') {
+                    c.page_replacement = c.page_replacement.substr(1, c.page_replacement.size() - 2);
+                }
+            }
+            else if (key == "flat-allocator") {
+                iss >> c.flat_allocator;
+                if (!c.flat_allocator.empty() && c.flat_allocator[0] == '"') {
+                    c.flat_allocator = c.flat_allocator.substr(1, c.flat_allocator.size() - 2);
+                }
+            }
+            else if (key == "bs-queue-depth") {
+                iss >> c.bs_queue_depth;
+            }
+            else if (key == "swap-slots") {
+                iss >> c.swap_slots;
+            }
+            else if (key == "fit-policy") {
+                iss >> c.fit_policy;
+                if (!c.fit_policy.empty() && c.fit_policy[0] == '"') {
+                    c.fit_policy = c.fit_policy.substr(1, c.fit_policy.size() - 2);
+                }
+            }
+            else if (key == "opt-oracle-refs") {
+                iss >> c.opt_oracle_refs;
+            }
+            else if (key == "mlfq-levels") {
+                iss >> c.mlfq_levels;
+            }
+            else if (key == "mlfq-quanta") {
+                c.mlfq_quanta.clear();
+                int q;
+                while (iss >> q) c.mlfq_quanta.push_back(q);
+            }
+            else if (key == "mlfq-boost") {
+                iss >> c.mlfq_boost;
+            }
+            else if (key == "page-fault-ticks") {
+                iss >> c.page_fault_ticks;
+            }
+            else if (key == "tlb-entries") {
+                iss >> c.tlb_entries;
+            }
+            else if (key == "tlb-ways") {
+                iss >> c.tlb_ways;
+            }
+            else if (key == "tlb-asid") {
+                iss >> c.tlb_asid;
+            }
+            else if (key == "trace-buffer") {
+                iss >> c.trace_buffer;
+            }
+            else if (key == "trace") {
+                iss >> c.trace_at_start;
+            }
+            else if (key == "dispatch-scan") {
+                iss >> c.dispatch_scan;
+            }
+            else if (key == "max-evictions-per-dispatch") {
+                iss >> c.max_evictions_per_dispatch;
+            }
+            else if (key == "balance-interval") {
+                iss >> c.balance_interval;
+            }
+            else if (key == "seed") {
+                iss >> c.seed;
+            }
+        }
+    }
+
+    string why = c.validate();
+    if (why != "") {
+        error = "Invalid config: " + why;
+        return false;
+    }
+    static_cast<SimConfig&>(*this) = c;
+
+    initialized = 1;
+    // queues are only ever added so a running clock never loses one
+    while ((int)runQueues.size() < num_cpu) runQueues.emplace_back();
+    for (auto& q : runQueues) {
+        lock_guard<mutex> lk(q.mtx);
+        if ((int)q.levels.size() < mlfq_levels) q.levels.resize(mlfq_levels);
+    }
+    schedulerPolicy.reset(makeScheduler(scheduler));
+    min_exp = log2(min_mem_per_proc);
+    physMem.assign(max_overall_mem / 2, 0);
+    max_exp = log2(max_mem_per_proc);
+    if (max_overall_mem == mem_per_frame) {
+        flat = true;
+        freeMem.clear();
+        freeBySize.clear();
+        takenMem.clear();
+        takenByPid.clear();
+        buddy = flat_allocator == "buddy";
+        if (buddy) initBuddy();
+        else insertFreeBlock(0, max_overall_mem-1);
+    } else {
+        flat = false;
+        total_frames = max_overall_mem / mem_per_frame;
+        frameMap.assign(total_frames, {-1, 0, -1});
+        replacementPolicy.reset(makeReplacementPolicy(page_replacement, total_frames));
+        pageTables.clear();
+        // reversed so frames are handed out from 0 upward
+        freeFrameList.clear();
+        for (int i = total_frames - 1; i >= 0; i--) {
+            freeFrameList.push_back(i);
+        }
+        // region locks are only ever added, like the run queues
+        int regions = (total_frames + FRAME_REGION_SIZE - 1) / FRAME_REGION_SIZE;
+        while ((int)frameRegionMtx.size() < regions) frameRegionMtx.emplace_back();
+    }
+    procMtx.lock();
+    rng.seed(seed);
+    procMtx.unlock();
+    // without a swap file every swap-out would be dropped and evicted processes would come back zeroed
+    if (!initSwap()) {
+        error = "Unable to map " + swapPath;
+        initialized = 0;
+        return false;
+    }
+    startBSThread();
+    return true;
+}
+
+// checked before configure takes the settings, so a rejected file changes nothing
+string SimConfig::validate() const {
+    if (num_cpu < 1) return "num-cpu must be at least 1";
+    if (scheduler != "fcfs" && scheduler != "rr" && scheduler != "mlfq") return "unknown scheduler \"" + scheduler + "\"";
+    if (scheduler != "fcfs" && quantum_cycles < 1) return "quantum-cycles must be at least 1";
+    if (delay_per_exec < 0) return "delay-per-exec can't be negative";
+    if (mlfq_levels < 1) return "mlfq-levels must be at least 1";
+    for (int q : mlfq_quanta) {
+        if (q < 1) return "mlfq-quanta must be at least 1";
+    }
+    if (mlfq_boost < 0 || balance_interval < 0 || dispatch_scan < 0 || max_evictions_per_dispatch < 0) {
+        return "mlfq-boost, balance-interval, dispatch-scan and max-evictions-per-dispatch can't be negative";
+    }
+    if (batch_process_freq < 0) return "batch-process-freq can't be negative";
+    if (min_ins < 1 || max_ins < min_ins) return "min-ins must be at least 1 and at most max-ins";
+    if (min_mem_per_proc < 1 || max_mem_per_proc < min_mem_per_proc) {
+        return "min-mem-per-proc must be at least 1 and at most max-mem-per-proc";
+    }
+    if (max_overall_mem < 1) return "max-overall-mem must be at least 1";
+    if (mem_per_frame < 1) return "mem-per-frame must be at least 1";
+    if (max_overall_mem % mem_per_frame != 0) return "mem-per-frame must divide max-overall-mem";
+    if (flat_allocator != "free-list" && flat_allocator != "buddy") return "unknown flat-allocator \"" + flat_allocator + "\"";
+    if (fit_policy != "first-fit" && fit_policy != "best-fit" && fit_policy != "worst-fit" && fit_policy != "next-fit") {
+        return "unknown fit-policy \"" + fit_policy + "\"";
+    }
+    if (page_replacement != "fifo" && page_replacement != "lru" && page_replacement != "clock" && page_replacement != "lfu") {
+        return "unknown page-replacement \"" + page_replacement + "\"";
+    }
+    if (page_fault_ticks < 0 || opt_oracle_refs < 0) return "page-fault-ticks and opt-oracle-refs can't be negative";
+    if (tlb_entries < 0) return "tlb-entries can't be negative";
+    if (tlb_ways < 1) return "tlb-ways must be at least 1";
+    if (bs_queue_depth < 1) return "bs-queue-depth must be at least 1";
+    if (trace_buffer < 1) return "trace-buffer must be at least 1";
+    return "";
+}
+
+
+
+// allocation algo for flat 
+// search free mem for space using fit_policy, if available, alloc and ret 1, else 0
+bool Simulator::AllocateFlat(int pid) {
+    const ProcessScreen& p = processes[pid];
+    lock_guard<mutex> lk(flatMtx);
+    if (buddy) {
+        // the taken block covers the whole 2^order block, mem keeps what was asked for
+        int order = buddyOrder(p.mem);
+        int start = buddyAlloc(order);
+        if (start == -1) return 0;
+        MemoryBlock newTakenBlock = {start, start + (1 << order) - 1, p.pid, p.mem, 0, 1};
+        takenMem.push_back(newTakenBlock);
+        takenByPid[p.pid] = std::prev(takenMem.end());
+        processes[pid].base = start;
+        return 1;
+    }
+    auto it = findFreeBlock(p.mem);
+    if (it == freeMem.end()) return 0;
+    MemoryBlock m = it->second;
+    eraseFreeBlock(it);
+    MemoryBlock newTakenBlock = {m.start, m.start+p.mem - 1, p.pid, p.mem, 0, 1};
+    takenMem.push_back(newTakenBlock);
+    takenByPid[p.pid] = std::prev(takenMem.end());
+    if (m.mem > p.mem) {
+        // leftover goes straight back, it can't touch another free block
+        MemoryBlock leftoverBlock = {m.start+p.mem, m.end, -1, m.mem-p.mem, 0, 0};
+        freeMem[leftoverBlock.start] = leftoverBlock;
+        freeBySize.insert({leftoverBlock.mem, leftoverBlock.start});
+    }
+    nextFitStart = m.start + p.mem;
+    processes[pid].base = m.start;
+    return 1;
+}
+
+// bring pid's symbol table back into its memory, one that never left memory starts zeroed
+void Simulator::restoreImage(int pid) {
+    ProcessScreen& p = processes[pid];
+    uint16_t* vars = physMem.data() + p.base / 2;
+    if (!loadImage(pid, vars, p.vars)) memset(vars, 0, p.vars * sizeof(uint16_t));
+}
+
+// return 1 if proc in main mem
+int Simulator::FlatMemAlloc(int pid) {
+    // remove from backing store if exists
+    BSRetrieve(pid);
+
+    // try allocating mem, if cant, swap out oldest
+    int evictions = 0;
+    while(!AllocateFlat(pid)){
+        int victim = -1;
+        if (max_evictions_per_dispatch > 0 && evictions == max_evictions_per_dispatch) {
+            num_eviction_limit++;
+            return 0;
+        }
+
+        // move oldest inactive from takenMem to freeMem
+        uint16_t image[SYMTAB_WORDS];
+        flatMtx.lock();
+        for (auto it = takenMem.begin(); it != takenMem.end(); ++it) {
+            if (it->active == 0) {
+                victim = it->pid;
+                memcpy(image, &physMem[it->start / 2], processes[victim].vars * sizeof(uint16_t));
+                freeTakenBlock(it);
+                break;
+            }
+        }
+        flatMtx.unlock();
+        // return if cant find any available space 
+        if (victim == -1) return 0;
+
+        // swap out outside of flatMtx
+        trace(TR_PAGE_OUT, victim, -1);
+        storeImage(victim, image, processes[victim].vars);
+        BSStore(victim);
+        evictions++;
+    }
+    trace(TR_PAGE_IN, pid, -1);
+    restoreImage(pid);
+
+    return true;
+}
+
+// record a reference for the offline opt oracle
+void Simulator::recordPageRef(int pid, int page, bool fault) {
+    if (opt_oracle_refs == 0) return;
+    lock_guard<mutex> lk(optMtx);
+    if ((int)optRefs.size() >= opt_oracle_refs) return;
+    optRefs.push_back(((long long)pid << 32) | page);
+    if (fault) opt_window_faults++;
+}
+
+// claim a free frame for page of p in O(1), return 1 if one was found
+// the frame starts pinned since p is running
+bool Simulator::AllocatePage(int pid, int page) {
+    int key;
+    {
+        lock_guard<mutex> lk(freeFrameMtx);
+        if (freeFrameList.empty()) return 0;
+        key = freeFrameList.back();
+        freeFrameList.pop_back();
+    }
+    lock_guard<mutex> lk(frameRegionMtx[key / FRAME_REGION_SIZE]);
+    frameMap[key].pid = pid;
+    frameMap[key].active = 1;
+    frameMap[key].page = page;
+    if (page == 0) processes[pid].base = key * mem_per_frame;
+    policyMtx.lock();
+    replacementPolicy->onLoad(key);
+    replacementPolicy->pin(key, true);
+    policyMtx.unlock();
+    lock_guard<mutex> ptLk(pageTableMtx);
+    PageTable& table = pageTables[pid];
+    table.frames[page] = key;
+    table.resident++;
+    num_paged_in++;
+    trace(TR_PAGE_IN, pid, page);
+    return 1;
+}
+
+// queue the invalidation of an evicted page on every core that may cache it
+// the victim isn't running, so its stale entries can't be used before those cores run again
+void Simulator::shootdownTLBs(int pid, int page, uint64_t cores) {
+    for (int i = 0; i < (int)tlbs.size(); i++) {
+        if (!(cores >> (i % 64) & 1)) continue;
+        lock_guard<mutex> lk(tlbs[i].shootMtx);
+        tlbs[i].pendingShoot.push_back({pid, page});
+        tlbs[i].shootPending = true;
+    }
+}
+
+// evict the policy's victim onto the free list, return the evicted pid or -1 if none
+int Simulator::EvictPage() {
+    while (true) {
+        policyMtx.lock();
+        int key = replacementPolicy->victim();
+        policyMtx.unlock();
+        if (key == -1) return -1;
+
+        // recheck under the region lock, a core may have released or pinned it in between
+        int victim, page;
+        uint64_t tlbCores = 0;
+        bool symtab;
+        uint16_t image[SYMTAB_WORDS];
+        {
+            lock_guard<mutex> lk(frameRegionMtx[key / FRAME_REGION_SIZE]);
+            PIDAge& frame = frameMap[key];
+            if (frame.active != 0) continue;
+            victim = frame.pid;
+            if (victim == -1) return -1; // freed by its core, AllocatePage will pick it up
+            page = frame.page;
+            symtab = page == 0;
+            if (symtab) memcpy(image, &physMem[key * mem_per_frame / 2], processes[victim].vars * sizeof(uint16_t));
+            {
+                lock_guard<mutex> ptLk(pageTableMtx);
+                auto it = pageTables.find(victim);
+                if (it != pageTables.end()) {
+                    it->second.swapped[page] = 1;
+                    tlbCores = it->second.tlbCores;
+                }
+            }
+            freeFrame(key);
+        }
+        if (tlbCores) shootdownTLBs(victim, page, tlbCores);
+        // the swap file is never touched under a frame lock
+        if (symtab) storeImage(victim, image, processes[victim].vars);
+        num_paged_out++;
+        trace(TR_PAGE_OUT, victim, page);
+        return victim;
+    }
+}
+
+// mark every resident frame of a process as in use by a cpu (or not), counting activation as an access
+void Simulator::ActivatePages(int pid, bool on) {
+    for (int key : residentFrames(pid)) {
+        lock_guard<mutex> lk(frameRegionMtx[key / FRAME_REGION_SIZE]);
+        if (frameMap[key].pid != pid) continue;
+        frameMap[key].active = on;
+        lock_guard<mutex> policyLk(policyMtx);
+        if (on) replacementPolicy->onAccess(key);
+        replacementPolicy->pin(key, on);
+    }
+}
+
+// demand paging: nothing is loaded at dispatch, the process faults pages in as it touches them
+// sets up the page table and pins what is still resident, always returns 1
+int Simulator::PagingAlloc(int pid) {
+    int pages = processes[pid].pages;
+    pageTableMtx.lock();
+    PageTable& table = pageTables[pid];
+    if ((int)table.frames.size() != pages) {
+        table.frames.assign(pages, -1);
+        table.swapped.assign(pages, 0);
+    }
+    pageTableMtx.unlock();
+
+    // pin what is already resident so the process never evicts its own pages
+    ActivatePages(pid, true);
+    return true;
+}
+
+// a running process referenced a resident page
+void Simulator::touchPage(int pid, int page, int frame) {
+    num_page_refs++;
+    recordPageRef(pid, page, false);
+    lock_guard<mutex> lk(policyMtx);
+    replacementPolicy->onAccess(frame);
+}
+
+// load page of the running process pid, evicting the policy's victim if no frame is free
+// returns 1 for a major fault (the page comes back from the backing store), 0 for a minor one (first touch)
+// or -1 if every frame is pinned
+int Simulator::pageFault(int pid, int page) {
+    while (!AllocatePage(pid, page)) {
+        int victim = EvictPage();
+        if (victim == -1) {
+            // a frame may have been freed by another core during the search
+            if (AllocatePage(pid, page)) break;
+            return -1;
+        }
+        // swap out outside of the frame locks
+        BSStore(victim);
+    }
+    pageTableMtx.lock();
+    char& swapped = pageTables[pid].swapped[page];
+    bool major = swapped;
+    swapped = 0;
+    pageTableMtx.unlock();
+    recordPageRef(pid, page, true);
+    if (major) {
+        BSRetrieve(pid);
+        num_major_faults++;
+    } else {
+        num_minor_faults++;
+    }
+    if (page == 0) restoreImage(pid);
+    return major;
+}
+
+
+// true if pid can be put in memory right now without evicting anything
+bool Simulator::fitsWithoutEviction(int pid) {
+    const ProcessScreen& p = processes[pid];
+    if (flat == 1) {
+        lock_guard<mutex> lk(flatMtx);
+        if (buddy) {
+            for (int order = buddyOrder(p.mem); order <= buddyMaxOrder; order++) {
+                if (!buddyFree[order].empty()) return true;
+            }
+            return false;
+        }
+        // every fit policy finds a block if the largest one is big enough
+        return !freeBySize.empty() && freeBySize.rbegin()->first >= p.mem;
+    }
+    // demand paging only needs the page the process resumes on, or a free frame to fault it into
+    if (p.pages == 0) return true;
+    pageTableMtx.lock();
+    auto it = pageTables.find(pid);
+    bool resident = it != pageTables.end() && (int)it->second.frames.size() == p.pages && it->second.frames[codePage(p, p.pc)] != -1;
+    pageTableMtx.unlock();
+    if (resident) return true;
+    lock_guard<mutex> lk(freeFrameMtx);
+    return !freeFrameList.empty();
+}
+
+// give core cpu the next process, preferring one that fits in memory, holding it for flagCounter
+// once a dispatch fails in a tick the rest only take what fits, so the queue doesn't rotate
+// through processes that would each evict and still fail
+void Simulator::dispatch(int cpu, int flagCounter) {
+    bool fitOnly = dispatchFailedTick == cpu_cycles;
+    int p = takeProcess(cpu, fitOnly);
+    if (p == -1) return;
+    // a restored process gets its program back the first time it is dispatched
+    if (!processes[p].code) loadProgram(p);
+    if ((flat == 1 && FlatMemAlloc(p)) || (flat == 0 && PagingAlloc(p))) {
+        // context switch, without asids the previous process's translations must go
+        if (flat == 0 && tlb_entries > 0 && !tlb_asid && tlbs[cpu].lastPid != p) tlbs[cpu].flush();
+        if (tlb_entries > 0) tlbs[cpu].lastPid = p;
+        ProcessScreen& ps = processes[p];
+        ps.waitTicks += cpu_cycles - ps.readySince;
+        if (ps.firstDispatchTick == -1) {
+            ps.firstDispatchTick = cpu_cycles;
+            responseHist.add(cpu_cycles - ps.arrivalTick);
+        }
+        trace(TR_DISPATCH, p, cpu);
+        coreProcesses[cpu].pid = p;
+        processes[p].core = cpu;
+        coreProcesses[cpu].flagCounter = flagCounter;
+    } else {
+        num_dispatch_failures++;
+        dispatchFailedTick = cpu_cycles;
+        trace(TR_ALLOC_FAIL, p, cpu);
+        pushRunQueueFront(cpu, p);
+    }
+}
+
+// round robin, each dispatch runs quantum-cycles lines in one execution and then goes to the back of the queue
+class RRScheduler : public Scheduler {
+public:
+    using Scheduler::Scheduler;
+    void tick() override {
+        int active = 0;
+        for (int i = 0; i < sim.num_cpu; i++) {
+            if (sim.coreProcesses[i].flagCounter == 0) {
+                // if process is not completed, add back to ready/waiting queue
+                if (sim.coreProcesses[i].pid != -1 && sim.processes[sim.coreProcesses[i].pid].currentLine < sim.processes[sim.coreProcesses[i].pid].totalLines) {
+                    sim.pushRunQueue(i, sim.coreProcesses[i].pid);
+                }
+                sim.coreProcesses[i].pid = -1;
+                sim.dispatch(i, sim.quantum_cycles);
+            } else {
+                active = 1;
+            }
+        }
+        if (active) sim.active_cpu_ticks++;
+    }
+    int linesPerExec(int pid) override { return sim.quantum_cycles; }
+    bool releaseAfterExec() override { return true; }
+};
+
+// first come first served, a process keeps its core one line per execution until it finishes
+class FCFSScheduler : public Scheduler {
+public:
+    using Scheduler::Scheduler;
+    void tick() override {
+        int active = 0;
+        for (int i = 0; i < sim.num_cpu; i++) {
+            if (sim.coreProcesses[i].flagCounter == 0) {
+                sim.dispatch(i, 1);
+            } else {
+                active = 1;
+            }
+        }
+        if (active) sim.active_cpu_ticks++;
+    }
+    int linesPerExec(int pid) override { return 1; }
+    bool releaseAfterExec() override { return false; }
+};
+
+// multi-level feedback queue: round robin over levels, a process that uses its whole slice
+// drops a level and gets a longer quantum, every mlfq-boost ticks the ones starved that long go back to the top
+class MLFQScheduler : public RRScheduler {
+public:
+    MLFQScheduler(Simulator& sim) : RRScheduler(sim) {
+        for (int l = 0; l < sim.mlfq_levels; l++) {
+            if (l < (int)sim.mlfq_quanta.size()) quanta.push_back(sim.mlfq_quanta[l]);
+            else quanta.push_back(l == 0 ? sim.quantum_cycles : quanta[l - 1] * 4);
+        }
+    }
+    void tick() override {
+        if (sim.mlfq_boost > 0 && sim.cpu_cycles % sim.mlfq_boost == 0) boost();
+        RRScheduler::tick();
+    }
+    int linesPerExec(int pid) override { return quanta[sim.processes[pid].level]; }
+    void onSliceEnd(int pid) override {
+        if (sim.processes[pid].level < sim.mlfq_levels - 1) sim.processes[pid].level++;
+    }
+private:
+    vector<int> quanta;
+    // moving everyone up would queue hundreds of long processes ahead of new arrivals,
+    // only those that have waited a whole period in a lower level are starving
+    void boost() {
+        for (auto& q : sim.runQueues) {
+            lock_guard<mutex> lk(q.mtx);
+            for (int l = 1; l < (int)q.levels.size(); l++) {
+                auto& level = q.levels[l];
+                for (auto it = level.begin(); it != level.end();) {
+                    if (sim.cpu_cycles - sim.processes[*it].readySince < sim.mlfq_boost) {
+                        ++it;
+                        continue;
+                    }
+                    sim.processes[*it].level = 0;
+                    q.levels[0].push_back(*it);
+                    it = level.erase(it);
+                }
+            }
+        }
+    }
+};
+
+Scheduler* Simulator::makeScheduler(const string& name) {
+    if (name == "fcfs") return new FCFSScheduler(*this);
+    if (name == "mlfq") return new MLFQScheduler(*this);
+    return new RRScheduler(*this); // rr
+}
+
+
+// one tlb per cpu, empty
+void Simulator::initTLBs() {
+    tlbs.clear();
+    tlbs.resize(num_cpu);
+    for (auto& tlb : tlbs) tlb.reset(max(tlb_entries, 1), tlb_ways);
+}
+
+// one trace ring per cpu plus the console and the clock, empty
+void Simulator::initTrace() {
+    tracing = false;
+    int size = 1;
+    while (size < trace_buffer) size *= 2;
+    traceRings.clear();
+    for (int i = 0; i < num_cpu + 2; i++) {
+        traceRings.emplace_back();
+        traceRings.back().events.resize(size);
+    }
+    tracing = trace_at_start != 0;
+}
+
+Simulator::Simulator() {
+    // a swap file of its own, so simulators in one process or in several never truncate each other's
+    static atomic<int> instances{0};
+#ifdef _WIN32
+    unsigned long processId = GetCurrentProcessId();
+#else
+    long processId = getpid();
+#endif
+    swapPath = "backing_store/swap-" + to_string(processId) + "-" + to_string(instances++) + ".bin";
+}
+
+Simulator::~Simulator() {
+    stop();
+    stopBSThread();
+    lock_guard<mutex> lk(bsMtx);
+#ifdef _WIN32
+    if (swapMap) UnmapViewOfFile(swapMap);
+    if (swapMapping) CloseHandle(swapMapping);
+    if (swapFile != INVALID_HANDLE_VALUE) {
+        CloseHandle(swapFile);
+        DeleteFileA(swapPath.c_str());
+    }
+#else
+    if (swapMap) munmap(swapMap, swapCapacity * sizeof(SwapSlot));
+    if (swapFd != -1) {
+        close(swapFd);
+        unlink(swapPath.c_str());
+    }
+#endif
+}
+
+bool Simulator::configure(const string& configPath) {
+    std::ifstream configFile(configPath);
+    if (!configFile) {
+        error = "Unable to open " + configPath + " file";
+        return false;
+    }
+    return configure(configFile);
+}
+
+bool Simulator::configure(istream& config) {
+    // rebuilding memory and the scheduler under live cores would pull them out from under running processes
+    if (clockThread.joinable()) {
+        error = "Already running, a config can only be loaded before the clock starts";
+        return false;
+    }
+    ostringstream text;
+    text << config.rdbuf();
+    istringstream in(text.str());
+    if (!initializeProgram(in)) return false;
+    configText = text.str();
+    error = "";
+    // cores built for the old config go, what they were running waits at the front of the run queues again
+    if (!coreProcesses.empty()) {
+        for (int i = 0; i < (int)coreProcesses.size(); i++) {
+            int p = coreProcesses[i].pid;
+            if (p == -1 || processes[p].currentLine >= processes[p].totalLines) continue;
+            processes[p].readySince = cpu_cycles;
+            pushRunQueueFront(i % num_cpu, p);
+        }
+        initCores();
+    }
+    return true;
+}
+
+int Simulator::submit(const string& name) {
+    int p = addProcess(name);
+    if (p != -1) submitProcess(p);
+    return p;
+}
+
+// idle cores, one per cpu, with fresh tlbs and trace rings. nothing may be running
+void Simulator::initCores() {
+    coreWork.assign(num_cpu, 0);
+    coreExecs.assign(num_cpu, 0);
+    coreInstrs.assign(num_cpu, 0);
+    initTLBs();
+    coreProcesses.clear();
+    coreCv.clear();
+    for (int i = 0; i < num_cpu; i++) {
+        CoreProcess cp;
+        cp.pid = -1;
+        cp.flagCounter = 0;
+        cp.stallUntil = 0;
+        cp.sliceLeft = 0;
+        coreProcesses.push_back(cp);
+        coreCv.emplace_back();
+    }
+    initTrace();
+}
+
+void Simulator::tick() {
+    if (coreProcesses.empty()) initCores();
+    int ring = traceRing;
+    traceRing = 1;
+    clockTick();
+    for (int i = 0; i < num_cpu; i++) {
+        if (coreDue(coreExecs[i]) && coreProcesses[i].flagCounter > 0) {
+            traceRing = i + 2;
+            coreStep(i);
+            traceRing = 1;
+        }
+    }
+    traceRing = ring;
+}
+
+void Simulator::run(long long ticks) {
+    for (long long t = 0; t < ticks; t++) tick();
+}
+
+void Simulator::start() {
+    if (clockThread.joinable()) return;
+    // a clock restarted after stop() picks up where the cores left off
+    if (coreProcesses.empty()) initCores();
+    coreStop = false;
+    shuttingDown = false;
+    clockThread = thread(&Simulator::startClock, this);
+}
+
+void Simulator::stop() {
+    shuttingDown = true;
+    if (clockThread.joinable()) clockThread.join();
+    coreThreads.clear();
+}
+
+SimStats Simulator::stats() {
+    SimStats s = {};
+    s.ticks = cpu_cycles;
+    s.activeTicks = active_cpu_ticks;
+    {
+        lock_guard<mutex> lk(procMtx);
+        s.processes = pid;
+    }
+    s.finished = turnaroundHist.total;
+    for (auto& cp : coreProcesses) {
+        if (cp.flagCounter > 0) s.running++;
+    }
+    s.ready = runQueueLength();
+    for (long long n : coreInstrs) s.instructions += n;
+    s.pagedIn = num_paged_in;
+    s.pagedOut = num_paged_out;
+    s.pageRefs = num_page_refs;
+    s.majorFaults = num_major_faults;
+    s.minorFaults = num_minor_faults;
+    long long shootdowns, flushes;
+    tlbTotals(s.tlbHits, s.tlbMisses, shootdowns, flushes);
+    s.dispatchFailures = num_dispatch_failures;
+    s.cpuUtilization = num_cpu > 0 ? s.running * 100.0 / num_cpu : 0;
+    LatencyHistogram* hists[] = {&turnaroundHist, &waitingHist, &responseHist};
+    long long* out[] = {s.turnaround, s.waiting, s.response};
+    for (int h = 0; h < 3; h++) {
+        out[h][0] = hists[h]->percentile(0.5);
+        out[h][1] = hists[h]->percentile(0.9);
+        out[h][2] = hists[h]->percentile(0.99);
+        out[h][3] = hists[h]->maxValue;
+        s.mean[h] = hists[h]->mean();
+    }
+    return s;
+}
+
+// workload trace: magic, version, then one native-endian Arrival per process in arrival order
+const char WORKLOAD_MAGIC[8] = {'C', 'S', 'O', 'P', 'W', 'K', 'L', 'D'};
+const uint32_t WORKLOAD_VERSION = 1;
+
+bool Simulator::recordWorkload(const string& path) {
+    lock_guard<mutex> lk(procMtx);
+    if (workloadOut.is_open()) workloadOut.close();
+    workloadOut.open(path, std::ios::binary | std::ios::trunc);
+    if (!workloadOut) return false;
+    workloadOut.write(WORKLOAD_MAGIC, sizeof(WORKLOAD_MAGIC));
+    workloadOut.write((const char*)&WORKLOAD_VERSION, sizeof(WORKLOAD_VERSION));
+    recordStart = cpu_cycles;
+    num_recorded = 0;
+    return (bool)workloadOut;
+}
+
+void Simulator::stopRecording() {
+    lock_guard<mutex> lk(procMtx);
+    if (workloadOut.is_open()) workloadOut.close();
+}
+
+bool Simulator::replayWorkload(const string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(WORKLOAD_MAGIC)];
+    uint32_t version = 0;
+    in.read(magic, sizeof(magic));
+    in.read((char*)&version, sizeof(version));
+    if (!in || memcmp(magic, WORKLOAD_MAGIC, sizeof(magic)) != 0 || version != WORKLOAD_VERSION) return false;
+    string records((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    vector<Arrival> arrivals(records.size() / sizeof(Arrival));
+    memcpy(arrivals.data(), records.data(), arrivals.size() * sizeof(Arrival));
+
+    lock_guard<mutex> lk(procMtx);
+    replayArrivals = move(arrivals);
+    replayNext = 0;
+    replayStart = cpu_cycles;
+    replaying = !replayArrivals.empty();
+    return true;
+}
+
+// submit the replayed arrivals due by this tick, called by the clock
+void Simulator::replayArrivalsDue() {
+    vector<Arrival> due;
+    procMtx.lock();
+    while (replayNext < replayArrivals.size() && replayArrivals[replayNext].tick <= cpu_cycles - replayStart) {
+        due.push_back(replayArrivals[replayNext++]);
+    }
+    if (replayNext == replayArrivals.size()) replaying = false;
+    procMtx.unlock();
+    for (auto& a : due) submitProcess(addProcess("", &a));
+}
+
+// one tick of the clock: schedule and generate dummy processes
+void Simulator::clockTick() {
+    cpu_cycles++;
+    if (balance_interval > 0 && cpu_cycles % balance_interval == 0) balanceRunQueues();
+    schedulerPolicy->tick();
+    
+    if (replaying) {
+        replayArrivalsDue();
+    } else if (generating == true && batch_process_freq != 0 && cpu_cycles % batch_process_freq == 0) {
+        submitProcess(addProcess(""));
+    }
+}
+
+void Simulator::startClock() {
+    for (int i = 0; i < num_cpu; i++) {
+        coreThreads.emplace_back(&Simulator::core, this, i);
+    }
+    traceRing = 1;
+
+    while (!shuttingDown) {
+        clockTick();
+        signalCores();
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+
+    // cores are idle between ticks, wake them up to exit
+    coreMtx.lock();
+    coreStop = true;
+    for (auto& cv : coreCv) cv.notify_one();
+    coreMtx.unlock();
+    for (auto& t : coreThreads) t.join();
+}
+
+// writes mean/p50/p90/p99/max of the latency histograms
+void Simulator::writeLatency(ostream& out) {
+    out << "Latency in ticks (" << turnaroundHist.total << " finished):\n";
+    out << std::left << std::setw(12) << "" << std::right << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p90"
+        << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+    pair<const char*, LatencyHistogram*> hists[] = {
+        {"Turnaround", &turnaroundHist}, {"Waiting", &waitingHist}, {"Response", &responseHist}};
+    for (auto& [name, h] : hists) {
+        out << std::left << std::setw(12) << name << std::right << std::setw(10) << (long long)llround(h->mean()) << std::setw(10) << h->percentile(0.5)
+            << std::setw(10) << h->percentile(0.9) << std::setw(10) << h->percentile(0.99) << std::setw(10) << h->maxValue << "\n";
+    }
+}
+
+// writes the report-util summary (same format as csopesy-log.txt)
+void Simulator::writeReportUtil(ostream& out) {
+    string formatTime;
+    ProcessScreen p;
+
+    int active_cores = 0;
+    for (int i = 0; i < num_cpu; i++) {
+        if (coreProcesses[i].flagCounter > 0) {
+            active_cores++;
+        }
+    }
+    float utilization = (active_cores / (float)num_cpu) * 100;
+
+    out << "CPU utilization: " << std::fixed << std::setprecision(2) << utilization << "%\n";
+    out << "Cores used: " << active_cores << "\n";
+    out << "Cores available: " << num_cpu - active_cores << "\n\n";
+    writeLatency(out);
+    out << "\n--------------------------------------\n";
+
+    out << "Running processes: \n";
+    for (int i = 0; i < num_cpu; i++) {
+        if (coreProcesses[i].flagCounter > 0 && coreProcesses[i].pid != -1 && processes[coreProcesses[i].pid].currentLine < processes[coreProcesses[i].pid].totalLines) {
+            p = processes[coreProcesses[i].pid];
+            formatTime = p.timeStamp;
+            formatTime.erase(10, 1);
+            out << p.processName << "\t(" << formatTime << ")\tCore: " << p.core
+                << "\t\t" << p.currentLine << " / " << p.totalLines << "\n";
+        }
+    }
+
+    out << "\nFinished processes: \n";
+    // the table is already in pid order
+    int count = processes.size();
+    for (int i = 0; i < count; i++) {
+        p = processes[i];
+        if (p.pid != -1 && p.currentLine >= p.totalLines) {
+            out << p.processName << "\t(" << p.timeStamp << ")\tCore: " << p.core
+                << "\t\t" << p.totalLines << " / " << p.totalLines << "\n";
+        }
+    }
+
+    out << "\n--------------------------------------\n\n";
+}
+
+// internal and external fragmentation of flat memory, as fractions
+// internal: space inside taken blocks that wasn't asked for, external: free space outside the largest free block
+void Simulator::flatFragmentation(double& internal, double& external) {
+    lock_guard<mutex> lk(flatMtx);
+    long long blockTotal = 0, requested = 0;
+    for (auto& m : takenMem) {
+        blockTotal += m.end - m.start + 1;
+        requested += m.mem;
+    }
+    long long freeTotal = 0, largest = 0;
+    if (buddy) {
+        for (int order = 0; order <= buddyMaxOrder; order++) {
+            freeTotal += (long long)buddyFree[order].size() << order;
+            if (!buddyFree[order].empty()) largest = 1LL << order;
+        }
+    } else {
+        for (auto& [start, m] : freeMem) freeTotal += m.mem;
+        if (!freeBySize.empty()) largest = freeBySize.rbegin()->first;
+    }
+    internal = blockTotal > 0 ? (blockTotal - requested) / (double)blockTotal : 0;
+    external = freeTotal > 0 ? 1 - largest / (double)freeTotal : 0;
+}
+
+string jsonEscape(const string& str) {
+    string escaped;
+    for (char c : str) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+// writes the trace rings as chrome trace json (chrome://tracing or ui.perfetto.dev), one tick shows as 1 us
+// a dispatch and the preempt or finish that ends it become one slice on the core's track, everything else
+// is an instant event on the track of the thread that recorded it. returns how many events were written
+long long Simulator::exportTrace(ostream& out) {
+    // copy each ring while it is being written, then drop what was overwritten during the copy
+    vector<pair<int, TraceEvent>> events; // (ring, event)
+    for (int r = 0; r < (int)traceRings.size(); r++) {
+        TraceRing& ring = traceRings[r];
+        uint64_t size = ring.events.size();
+        uint64_t head = ring.head.load(memory_order_acquire);
+        uint64_t first = head > size ? head - size : 0;
+        vector<TraceEvent> copied;
+        for (uint64_t i = first; i < head; i++) copied.push_back(ring.events[i & (size - 1)]);
+        uint64_t after = ring.head.load(memory_order_acquire);
+        uint64_t valid = after >= size ? after - size + 1 : 0;
+        for (uint64_t i = max(first, valid); i < head; i++) events.push_back({r, copied[i - first]});
+    }
+    // the clock dispatches before the cores run in a tick, so ring order breaks ties
+    stable_sort(events.begin(), events.end(), [](auto& a, auto& b) { return a.second.tick < b.second.tick; });
+
+    static const char* names[] = {"arrive", "dispatch", "preempt", "finish", "page-in", "page-out", "alloc-fail"};
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    out << "{\"ph\":\"M\",\"pid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"csopesy\"}}";
+    for (int r = 0; r < (int)traceRings.size(); r++) {
+        string name = r == 0 ? "console" : (r == 1 ? "scheduler" : "core " + to_string(r - 2));
+        out << ",\n{\"ph\":\"M\",\"pid\":0,\"tid\":" << r << ",\"name\":\"thread_name\",\"args\":{\"name\":\"" << name << "\"}}";
+        out << ",\n{\"ph\":\"M\",\"pid\":0,\"tid\":" << r << ",\"name\":\"thread_sort_index\",\"args\":{\"sort_index\":" << r << "}}";
+    }
+    vector<pair<int, int>> running(traceRings.size(), {-1, 0}); // per core track: (pid, dispatch tick)
+    auto slice = [&](int core, int endTick, const char* end) {
+        auto [pid, start] = running[core + 2];
+        out << ",\n{\"ph\":\"X\",\"pid\":0,\"tid\":" << core + 2 << ",\"ts\":" << start << ",\"dur\":" << endTick - start + 1
+            << ",\"name\":\"" << jsonEscape(processes[pid].processName) << "\",\"args\":{\"pid\":" << pid << ",\"end\":\"" << end << "\"}}";
+        running[core + 2].first = -1;
+    };
+    long long written = 0;
+    int lastTick = 0;
+    for (auto& [r, e] : events) {
+        lastTick = e.tick;
+        written++;
+        if (e.type == TR_DISPATCH || e.type == TR_PREEMPT || e.type == TR_FINISH) {
+            if (e.arg + 2 >= (int)running.size()) continue;
+            int& pid = running[e.arg + 2].first;
+            if (e.type == TR_DISPATCH) {
+                // the end of the previous slice was overwritten
+                if (pid != -1) slice(e.arg, e.tick, "unknown");
+                running[e.arg + 2] = {e.pid, e.tick};
+            } else if (pid == e.pid) {
+                slice(e.arg, e.tick, names[e.type]);
+            }
+            continue;
+        }
+        out << ",\n{\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":" << r << ",\"ts\":" << e.tick << ",\"name\":\"" << names[e.type]
+            << "\",\"args\":{\"pid\":" << e.pid << "," << (e.type == TR_ARRIVE ? "\"queue\"" : (e.type == TR_ALLOC_FAIL ? "\"core\"" : "\"page\""))
+            << ":" << e.arg << "}}";
+    }
+    // still running when the trace was taken
+    for (int core = 0; core + 2 < (int)running.size(); core++) {
+        if (running[core + 2].first != -1) slice(core, lastTick, "running");
+    }
+    out << "\n]}\n";
+    return written;
+}
+
+// tlb counters summed over the cores
+void Simulator::tlbTotals(long long& hits, long long& misses, long long& shootdowns, long long& flushes) {
+    hits = misses = shootdowns = flushes = 0;
+    for (auto& tlb : tlbs) {
+        hits += tlb.hits;
+        misses += tlb.misses;
+        shootdowns += tlb.shootdowns;
+        flushes += tlb.flushes;
+    }
+}
+
+// memory held right now: the blocks of running processes, or every frame in use under paging
+int Simulator::usedMemory() {
+    int mem_used = 0;
+    if (flat == 1) {
+        for (int i = 0; i < num_cpu; i++) {
+            if (coreProcesses[i].flagCounter > 0) {
+                mem_used += processes[coreProcesses[i].pid].mem;
+            }
+        }
+    } else {
+        // demand paging only loads what is touched, so count the frames in use rather than whole processes
+        lock_guard<mutex> lk(freeFrameMtx);
+        mem_used = (total_frames - (int)freeFrameList.size()) * mem_per_frame;
+    }
+    return mem_used;
+}
+
+// writes the vmstat summary
+void Simulator::writeVmstat(ostream& out) {
+    int mem_used = usedMemory();
+    out << "------------------------------------------- \n";
+    out << "Total memory: " << max_overall_mem << "\n";
+    out << "Used memory: " << mem_used << "\n";
+    out << "Free memory: " << max_overall_mem - mem_used << "\n"; // idk if free mem includes mem blocks that are in memory but are just from prev processes that arent in use anymore
+    out << "Idle cpu ticks: " << cpu_cycles-active_cpu_ticks << "\n";
+    out << "Active cpu ticks: " << active_cpu_ticks << "\n";
+    out << "Total cpu ticks: " << cpu_cycles << "\n";
+    out << "Num paged in: " << num_paged_in << "\n";
+    out << "Num paged out: " << num_paged_out << "\n";
+    long long instrs = 0;
+    for (long long n : coreInstrs) instrs += n;
+    out << "Instructions executed: " << instrs << "\n";
+    int shortest = runQueues[0].length, longest = shortest;
+    for (auto& q : runQueues) {
+        shortest = min(shortest, q.length.load());
+        longest = max(longest, q.length.load());
+    }
+    out << "Ready processes: " << runQueueLength() << " (per core " << shortest << " - " << longest << ")\n";
+    out << "Run queue steals: " << num_steals << ", balance moves: " << num_balance_moves << "\n";
+    out << "Dispatch failures: " << num_dispatch_failures << " (eviction limit " << num_eviction_limit << ")"
+        << ", dispatched ahead of head: " << num_dispatch_ahead << "\n";
+    bsMtx.lock();
+    out << "Swap slots used: " << swapUsed << " / " << swapCapacity << "\n";
+    bsMtx.unlock();
+    bsQueueMtx.lock();
+    out << "BS queue depth: " << bsQueue.size() << " (max " << bs_max_depth << " / " << bs_queue_depth << ")\n";
+    out << "BS requests done: " << bs_ops_done << " in " << bs_batches << " batches, "
+        << bs_coalesced << " coalesced, " << bs_stalls << " stalls\n";
+    out << "BS avg latency: " << std::fixed << std::setprecision(2) << (bs_ops_done > 0 ? bs_latency_us / bs_ops_done : 0.0) << " us\n";
+    bsQueueMtx.unlock();
+    if (flat == 1) {
+        double internal, external;
+        flatFragmentation(internal, external);
+        out << "Flat allocator: " << (buddy ? "buddy" : flat_allocator + " (" + fit_policy + ")") << "\n";
+        out << "Internal fragmentation: " << std::fixed << std::setprecision(2) << internal * 100 << "%\n";
+        out << "External fragmentation: " << std::fixed << std::setprecision(2) << external * 100 << "%\n";
+    }
+    if (flat == 0) {
+        out << "Page replacement: " << page_replacement << "\n";
+        out << "Page references: " << num_page_refs << "\n";
+        out << "Page faults: " << num_major_faults << " major, " << num_minor_faults << " minor\n";
+        out << "Page fault rate: " << std::fixed << std::setprecision(2) << (num_page_refs > 0 ? (num_major_faults + num_minor_faults) * 100.0 / num_page_refs : 0.0) << "%\n";
+        if (tlb_entries > 0) {
+            long long hits, misses, shootdowns, flushes;
+            tlbTotals(hits, misses, shootdowns, flushes);
+            out << "TLB: " << tlbs[0].sets << " sets x " << tlbs[0].ways << " ways per core, " << (tlb_asid ? "asid tagged" : "flushed on switch") << "\n";
+            out << "TLB hits: " << hits << ", misses: " << misses << " (hit rate " << std::fixed << std::setprecision(2)
+                << (hits + misses > 0 ? hits * 100.0 / (hits + misses) : 0.0) << "%)\n";
+            out << "TLB shootdowns: " << shootdowns << ", flushes: " << flushes << "\n";
+        }
+        if (opt_oracle_refs > 0) {
+            optMtx.lock();
+            vector<long long> refs = optRefs;
+            long long policyFaults = opt_window_faults;
+            optMtx.unlock();
+            out << "OPT oracle faults (first " << refs.size() << " refs): " << optFaults(refs, total_frames)
+                << " vs " << page_replacement << ": " << policyFaults << "\n";
+        }
+    }
+    out << "------------------------------------------- \n";
+}
+
+// snapshot layout: magic, version, the config text, then every piece of dynamic state in a fixed order
+// trace rings and an open workload recording aren't saved, a restored simulation starts with empty rings
+const char SNAPSHOT_MAGIC[8] = {'C', 'S', 'O', 'P', 'S', 'N', 'A', 'P'};
+const uint32_t SNAPSHOT_VERSION = 4; // bump whenever the layout below changes
+
+static void putHistogram(SnapshotWriter& w, const LatencyHistogram& h) {
+    for (auto& c : h.counts) w.put(c.load());
+    w.put(h.total.load());
+    w.put(h.sum.load());
+    w.put(h.maxValue.load());
+}
+
+static void getHistogram(SnapshotReader& r, LatencyHistogram& h) {
+    for (auto& c : h.counts) c = r.get<long long>();
+    h.total = r.get<long long>();
+    h.sum = r.get<long long>();
+    h.maxValue = r.get<long long>();
+}
+
+// pids of a map in ascending order, so the same state always gives the same snapshot
+template <typename M>
+static vector<int> sortedPids(const M& m) {
+    vector<int> pids;
+    pids.reserve(m.size());
+    for (auto& entry : m) pids.push_back(entry.first);
+    sort(pids.begin(), pids.end());
+    return pids;
+}
+
+// the clock must be stopped and the backing store queue drained
+void Simulator::saveState(SnapshotWriter& w) {
+    // sizing the buffer up front saves copying it as it grows
+    size_t estimate = physMem.size() * 2 + frameMap.size() * sizeof(PIDAge) * 2 + swapUsed * (sizeof(SwapSlot) + 12) +
+                      swapSlotsByPid.size() * 16 + swapImageSlot.size() * 8 + bsStoredCount.size() * 8 + processes.size() * 160;
+    for (auto& [p, pt] : pageTables) estimate += pt.frames.size() * 5 + 40;
+    w.buf.reserve(estimate + estimate / 8);
+    w.buf.append(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    w.put(SNAPSHOT_VERSION);
+    w.putStr(configText);
+
+    // counters
+    w.put(cpu_cycles);
+    w.put(pid);
+    w.put(active_cpu_ticks);
+    w.put(generating);
+    w.put(num_dispatch_failures);
+    w.put(num_eviction_limit);
+    w.put(dispatchFailedTick);
+    w.put(num_paged_in.load());
+    w.put(num_paged_out.load());
+    w.put(num_page_refs.load());
+    w.put(num_major_faults.load());
+    w.put(num_minor_faults.load());
+    w.put(opt_window_faults);
+    w.putVec(optRefs);
+    w.put(num_steals);
+    w.put(num_balance_moves);
+    w.put(num_dispatch_ahead);
+    w.put(nextSubmit.load());
+    w.put(nextFitStart);
+    w.put((uint64_t)bs_max_depth);
+    w.put(bs_ops_done);
+    w.put(bs_batches);
+    w.put(bs_coalesced);
+    w.put(bs_stalls);
+    w.put(bs_latency_us);
+    putHistogram(w, turnaroundHist);
+    putHistogram(w, waitingHist);
+    putHistogram(w, responseHist);
+    w.put(rng.state);
+    w.put(replayStart);
+    w.putVec(vector<Arrival>(replayArrivals.begin() + replayNext, replayArrivals.end()));
+
+    // processes, programs are regenerated from their seeds so only the seeds are saved
+    int count = processes.size();
+    w.put(count);
+    for (int i = 0; i < count; i++) {
+        const ProcessScreen& p = processes[i];
+        w.put(p.pid);
+        if (p.pid == -1) continue;
+        w.putStr(p.processName);
+        w.putStr(p.timeStamp);
+        w.put(p.currentLine);
+        w.put(p.totalLines);
+        w.put(p.core);
+        w.put(p.mem);
+        w.put(p.pages);
+        w.put(p.level);
+        w.put(p.codeSize);
+        w.put(p.programSeed);
+        w.put(p.pc);
+        w.put(p.vars);
+        w.put(p.base);
+        w.put(p.sleepUntil);
+        w.put(p.prints);
+        w.put(p.loopLeft);
+        w.put(p.tlbHits);
+        w.put(p.tlbMisses);
+        w.put(p.arrivalTick);
+        w.put(p.firstDispatchTick);
+        w.put(p.completionTick);
+        w.put(p.readySince);
+        w.put(p.waitTicks);
+    }
+
+    // run queues and cores
+    w.put((uint64_t)runQueues.size());
+    for (auto& q : runQueues) {
+        w.put((uint64_t)q.levels.size());
+        for (auto& level : q.levels) w.putVec(vector<int>(level.begin(), level.end()));
+        w.put(q.length.load());
+        w.put(q.bypassed);
+    }
+    w.putVec(coreProcesses);
+    w.putVec(coreExecs);
+    w.putVec(coreInstrs);
+    for (auto& tlb : tlbs) {
+        w.putVec(tlb.entries);
+        w.put(tlb.clock);
+        w.put(tlb.lastPid);
+        w.put(tlb.hits);
+        w.put(tlb.misses);
+        w.put(tlb.shootdowns);
+        w.put(tlb.flushes);
+        vector<int> shoot;
+        for (auto& [p, page] : tlb.pendingShoot) {
+            shoot.push_back(p);
+            shoot.push_back(page);
+        }
+        w.putVec(shoot);
+    }
+
+    // memory
+    w.putVec(physMem);
+    if (flat) {
+        vector<MemoryBlock> blocks;
+        for (auto& [start, m] : freeMem) blocks.push_back(m);
+        w.putVec(blocks);
+        w.putVec(vector<MemoryBlock>(takenMem.begin(), takenMem.end()));
+        w.put((uint64_t)buddyFree.size());
+        for (auto& order : buddyFree) w.putVec(vector<int>(order.begin(), order.end()));
+    } else {
+        w.putVec(frameMap);
+        w.putVec(freeFrameList);
+        w.put((uint64_t)pageTables.size());
+        for (int p : sortedPids(pageTables)) {
+            PageTable& pt = pageTables[p];
+            w.put(p);
+            w.putVec(pt.frames);
+            w.putVec(pt.swapped);
+            w.put(pt.resident);
+            w.put(pt.tlbCores);
+        }
+        replacementPolicy->save(w);
+    }
+
+    // backing store, only the slots in use
+    w.put((uint64_t)swapCapacity);
+    w.put((uint64_t)swapHint);
+    w.put((uint64_t)swapUsed);
+    for (size_t slot = 0; slot < swapCapacity; slot++) {
+        if (!(swapBitmap[slot / 64] >> (slot % 64) & 1)) continue;
+        w.put((uint64_t)slot);
+        w.put(swapMap[slot]);
+    }
+    w.put((uint64_t)swapSlotsByPid.size());
+    for (int p : sortedPids(swapSlotsByPid)) {
+        w.put(p);
+        w.putVec(swapSlotsByPid[p]);
+    }
+    w.put((uint64_t)swapImageSlot.size());
+    for (int p : sortedPids(swapImageSlot)) {
+        w.put(p);
+        w.put(swapImageSlot[p]);
+    }
+    w.put((uint64_t)bsStoredCount.size());
+    for (int p : sortedPids(bsStoredCount)) {
+        w.put(p);
+        w.put(bsStoredCount[p]);
+    }
+}
+
+// the clock must be stopped and the backing store queue drained
+// false if the snapshot is from another version or cut short, which leaves the simulation half restored
+bool Simulator::loadState(SnapshotReader& r) {
+    if (r.end - r.p < (ptrdiff_t)sizeof(SNAPSHOT_MAGIC) || memcmp(r.p, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) return false;
+    r.p += sizeof(SNAPSHOT_MAGIC);
+    if (r.get<uint32_t>() != SNAPSHOT_VERSION) return false;
+    string config = r.getStr();
+    if (!r.ok) return false;
+
+    // the config sizes memory, queues, tlbs and the replacement policy and truncates the swap file
+    istringstream in(config);
+    if (!configure(in)) return false;
+    bool wasTracing = tracing;
+    initCores();
+    tracing = wasTracing;
+
+    cpu_cycles = r.get<int>();
+    pid = r.get<int>();
+    active_cpu_ticks = r.get<int>();
+    generating = r.get<int>();
+    num_dispatch_failures = r.get<long long>();
+    num_eviction_limit = r.get<long long>();
+    dispatchFailedTick = r.get<int>();
+    num_paged_in = r.get<int>();
+    num_paged_out = r.get<int>();
+    num_page_refs = r.get<long long>();
+    num_major_faults = r.get<long long>();
+    num_minor_faults = r.get<long long>();
+    opt_window_faults = r.get<long long>();
+    r.getVec(optRefs);
+    num_steals = r.get<long long>();
+    num_balance_moves = r.get<long long>();
+    num_dispatch_ahead = r.get<long long>();
+    nextSubmit = r.get<int>();
+    nextFitStart = r.get<int>();
+    bs_max_depth = r.get<uint64_t>();
+    bs_ops_done = r.get<long long>();
+    bs_batches = r.get<long long>();
+    bs_coalesced = r.get<long long>();
+    bs_stalls = r.get<long long>();
+    bs_latency_us = r.get<double>();
+    getHistogram(r, turnaroundHist);
+    getHistogram(r, waitingHist);
+    getHistogram(r, responseHist);
+    rng.state = r.get<uint32_t>();
+    if (rng.state == 0) rng.state = 1;
+    replayStart = r.get<int>();
+    r.getVec(replayArrivals);
+    replayNext = 0;
+    replaying = !replayArrivals.empty();
+
+    processes.clear();
+    processIndex.clear();
+    int count = r.get<int>();
+    for (int i = 0; i < count && r.ok; i++) {
+        ProcessScreen p = {};
+        p.pid = r.get<int>();
+        if (p.pid == -1) continue;
+        p.processName = r.getStr();
+        p.timeStamp = r.getStr();
+        p.currentLine = r.get<int>();
+        p.totalLines = r.get<int>();
+        p.core = r.get<int>();
+        p.mem = r.get<int>();
+        p.pages = r.get<int>();
+        p.level = r.get<int>();
+        p.codeSize = r.get<int>();
+        p.programSeed = r.get<uint32_t>();
+        p.pc = r.get<int>();
+        p.vars = r.get<int>();
+        p.base = r.get<int>();
+        p.sleepUntil = r.get<int>();
+        p.prints = r.get<int>();
+        for (auto& left : p.loopLeft) left = r.get<uint16_t>();
+        p.tlbHits = r.get<long long>();
+        p.tlbMisses = r.get<long long>();
+        p.arrivalTick = r.get<int>();
+        p.firstDispatchTick = r.get<int>();
+        p.completionTick = r.get<int>();
+        p.readySince = r.get<int>();
+        p.waitTicks = r.get<int>();
+        if (p.pid != i) r.ok = false;
+        if (!r.ok) break;
+        processes.add(p);
+        processIndex[p.processName] = p.pid;
+    }
+    // programs come back lazily at dispatch, generating them all here would take most of the restore
+    programs.clear();
+
+    uint64_t numQueues = r.get<uint64_t>();
+    if (numQueues > (uint64_t)(r.end - r.p)) r.ok = false;
+    while (r.ok && runQueues.size() < numQueues) runQueues.emplace_back();
+    for (uint64_t i = 0; i < runQueues.size() && r.ok; i++) {
+        RunQueue& q = runQueues[i];
+        lock_guard<mutex> lk(q.mtx);
+        for (auto& level : q.levels) level.clear();
+        q.length = 0;
+        q.bypassed = 0;
+        if (i >= numQueues) continue;
+        uint64_t levels = r.get<uint64_t>();
+        if (levels > (uint64_t)(r.end - r.p)) r.ok = false;
+        if (!r.ok) break;
+        if (q.levels.size() < levels) q.levels.resize(levels);
+        for (uint64_t l = 0; l < levels; l++) {
+            vector<int> level;
+            r.getVec(level);
+            q.levels[l].assign(level.begin(), level.end());
+        }
+        q.length = r.get<int>();
+        q.bypassed = r.get<int>();
+    }
+    r.getVec(coreProcesses);
+    r.getVec(coreExecs);
+    r.getVec(coreInstrs);
+    if ((int)coreProcesses.size() != num_cpu || (int)coreExecs.size() != num_cpu || (int)coreInstrs.size() != num_cpu) r.ok = false;
+    // processes already on a core won't pass through dispatch again
+    for (auto& cp : coreProcesses) {
+        if (!r.ok || cp.pid == -1) continue;
+        if (cp.pid < 0 || cp.pid >= processes.size() || processes[cp.pid].pid == -1) r.ok = false;
+        else loadProgram(cp.pid);
+    }
+    for (auto& tlb : tlbs) {
+        if (!r.ok) break;
+        size_t entries = tlb.entries.size();
+        r.getVec(tlb.entries);
+        if (tlb.entries.size() != entries) r.ok = false;
+        tlb.clock = r.get<unsigned>();
+        tlb.lastPid = r.get<int>();
+        tlb.hits = r.get<long long>();
+        tlb.misses = r.get<long long>();
+        tlb.shootdowns = r.get<long long>();
+        tlb.flushes = r.get<long long>();
+        vector<int> shoot;
+        r.getVec(shoot);
+        tlb.pendingShoot.clear();
+        for (size_t i = 0; i + 1 < shoot.size(); i += 2) tlb.pendingShoot.push_back({shoot[i], shoot[i + 1]});
+        tlb.shootPending = !tlb.pendingShoot.empty();
+    }
+
+    size_t memWords = physMem.size();
+    r.getVec(physMem);
+    if (physMem.size() != memWords) r.ok = false;
+    if (flat) {
+        vector<MemoryBlock> blocks;
+        r.getVec(blocks);
+        freeMem.clear();
+        freeBySize.clear();
+        for (auto& m : blocks) {
+            freeMem[m.start] = m;
+            freeBySize.insert({m.mem, m.start});
+        }
+        r.getVec(blocks);
+        takenMem.assign(blocks.begin(), blocks.end());
+        takenByPid.clear();
+        for (auto it = takenMem.begin(); it != takenMem.end(); ++it) takenByPid[it->pid] = it;
+        uint64_t orders = r.get<uint64_t>();
+        if (orders > 64) r.ok = false;
+        buddyFree.assign(r.ok ? orders : 0, {});
+        for (auto& order : buddyFree) {
+            vector<int> starts;
+            r.getVec(starts);
+            order.insert(starts.begin(), starts.end());
+        }
+    } else {
+        size_t frames = frameMap.size();
+        r.getVec(frameMap);
+        r.getVec(freeFrameList);
+        if (frameMap.size() != frames) r.ok = false;
+        pageTables.clear();
+        uint64_t tables = r.get<uint64_t>();
+        for (uint64_t i = 0; i < tables && r.ok; i++) {
+            int p = r.get<int>();
+            PageTable& pt = pageTables[p];
+            r.getVec(pt.frames);
+            r.getVec(pt.swapped);
+            pt.resident = r.get<int>();
+            pt.tlbCores = r.get<uint64_t>();
+        }
+        if (r.ok) replacementPolicy->load(r);
+    }
+
+    lock_guard<mutex> lk(bsMtx);
+    uint64_t capacity = r.get<uint64_t>();
+    swapHint = r.get<uint64_t>();
+    uint64_t used = r.get<uint64_t>();
+    if (!r.ok || used > capacity || used > (uint64_t)(r.end - r.p) / sizeof(SwapSlot)) return false;
+    if (capacity > swapCapacity && !mapSwapFile(capacity)) return false;
+    for (uint64_t i = 0; i < used && r.ok; i++) {
+        uint64_t slot = r.get<uint64_t>();
+        SwapSlot data = r.get<SwapSlot>();
+        if (slot >= capacity) r.ok = false;
+        if (!r.ok) break;
+        swapMap[slot] = data;
+        swapBitmap[slot / 64] |= 1ULL << (slot % 64);
+    }
+    swapUsed = used;
+    if (swapHint >= swapBitmap.size()) swapHint = 0;
+    uint64_t n = r.get<uint64_t>();
+    for (uint64_t i = 0; i < n && r.ok; i++) {
+        int p = r.get<int>();
+        r.getVec(swapSlotsByPid[p]);
+    }
+    n = r.get<uint64_t>();
+    for (uint64_t i = 0; i < n && r.ok; i++) {
+        int p = r.get<int>();
+        swapImageSlot[p] = r.get<int>();
+    }
+    bsStoredCount.clear();
+    n = r.get<uint64_t>();
+    for (uint64_t i = 0; i < n && r.ok; i++) {
+        int p = r.get<int>();
+        bsStoredCount[p] = r.get<int>();
+    }
+    return r.ok && r.p == r.end;
+}
+
+bool Simulator::checkpoint(const string& path) {
+    bool running = clockThread.joinable();
+    stop();
+    BSFlush();
+    if (coreProcesses.empty()) initCores();
+    SnapshotWriter w;
+    saveState(w);
+    if (running) start();
+    std::ofstream out(path, std::ios::binary);
+    out.write(w.buf.data(), w.buf.size());
+    return (bool)out;
+}
+
+bool Simulator::restore(const string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "Unable to open " + path;
+        return false;
+    }
+    string buf((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    if (buf.size() < sizeof(SNAPSHOT_MAGIC) + sizeof(SNAPSHOT_VERSION) || memcmp(buf.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        error = path + " is not a snapshot";
+        return false;
+    }
+    uint32_t version;
+    memcpy(&version, buf.data() + sizeof(SNAPSHOT_MAGIC), sizeof(version));
+    if (version != SNAPSHOT_VERSION) {
+        error = path + " is a version " + to_string(version) + " snapshot, expected " + to_string(SNAPSHOT_VERSION);
+        return false;
+    }
+    // a snapshot that is cut short or corrupt would leave this simulation half restored,
+    // so it is loaded into a scratch one first and the running simulation is only touched once that works
+    {
+        Simulator scratch;
+        SnapshotReader r = {buf.data(), buf.data() + buf.size()};
+        if (!scratch.loadState(r)) {
+            error = scratch.error != "" ? scratch.error : path + " is damaged or cut short";
+            return false;
+        }
+    }
+    bool running = clockThread.joinable();
+    stop();
+    BSFlush();
+    SnapshotReader r = {buf.data(), buf.data() + buf.size()};
+    bool ok = loadState(r);
+    if (running) start();
+    return ok;
+}
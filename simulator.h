@@ -0,0 +1,683 @@
+// the simulation engine: processes, schedulers, flat or paged memory, the backing store and stats
+// a Simulator owns all of its state, so several can run side by side in one process
+// the curses front end (main.cpp) and bench.cpp drive it through the members below
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <iostream>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <list>
+#include <set>
+#include <tuple>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <thread>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <fstream>
+#include <chrono>
+#include <cmath>
+
+const int FRAME_REGION_SIZE = 64;   // frames per independently locked region of the frame table
+
+
+// process programs are a compact instruction stream run by the cores
+// FOR pushes a loop at depth dst that repeats imm times, END jumps back to pc imm until it runs out
+// FOR and END are control flow and don't count as lines, everything else is one line
+enum Opcode : uint8_t { OP_PRINT, OP_DECLARE, OP_ADD, OP_SUBTRACT, OP_SLEEP, OP_FOR, OP_END };
+const uint8_t VAR_IMM = 0xFF;   // operand a or b is imm instead of a variable
+const int SYMTAB_WORDS = 28;    // uint16 variables at the start of a process's memory, one swap slot of data
+const int MAX_LOOP_DEPTH = 3;
+// xorshift32, each simulation draws its workload from one seeded with the seed config key
+// and every process's program from one seeded by that
+struct XorShift {
+    uint32_t state;
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    // mix the seed so small seeds don't start with a run of small numbers, the state is never 0
+    void seed(unsigned long long s) {
+        uint32_t x = (uint32_t)(s ^ (s >> 32));
+        x ^= x >> 16;
+        x *= 0x85ebca6bu;
+        x ^= x >> 13;
+        x *= 0xc2b2ae35u;
+        x ^= x >> 16;
+        state = x ? x : 1;
+    }
+};
+
+// one process arrival in a workload trace, ticks count from the start of the recording
+struct Arrival {
+    int32_t tick;
+    int32_t lines;
+    int32_t mem;
+    uint32_t programSeed;
+};
+
+struct Instr {
+    uint8_t op;
+    uint8_t dst;  // variable written, or loop depth of FOR/END
+    uint8_t a, b; // source variables of ADD/SUBTRACT
+    uint32_t imm; // DECLARE value, SLEEP ticks, FOR repeats, END jump target or an immediate operand
+};
+
+// struct used for each new instance of a process screen
+struct ProcessScreen {
+    int pid;
+    std::string processName;
+    int currentLine;
+    int totalLines;
+    std::string timeStamp;
+    int core;
+    int mem;
+    int pages;
+    int level; // mlfq priority level, 0 is the highest
+    const Instr* code;               // program, owned by programs until the process finishes, null until a restored process runs
+    int codeSize;
+    uint32_t programSeed;            // generates the program, so a snapshot needn't store it
+    int pc;                          // next instruction
+    int vars;                        // variables in the symbol table, fits in mem and in one frame
+    int base;                        // address of the symbol table while in memory
+    int sleepUntil;                  // cpu_cycles the process sleeps until
+    int prints;
+    uint16_t loopLeft[MAX_LOOP_DEPTH];
+    long long tlbHits;               // translations its cores found in their tlb
+    long long tlbMisses;             // translations that walked the page table
+    int arrivalTick;                 // cpu_cycles when the process was created
+    int firstDispatchTick;           // cpu_cycles of its first dispatch, -1 until then
+    int completionTick;              // cpu_cycles when it finished, -1 until then
+    int readySince;                  // cpu_cycles it last entered a run queue
+    int waitTicks;                   // ticks spent in run queues so far
+};
+
+// struct for each core process 
+struct CoreProcess {
+    int pid;                // pid of the process the cpu is handling, -1 if none
+    int flagCounter;        // > 0 means cpu is executing something
+    int stallUntil;         // cpu_cycles the core waits until for a major page fault
+    int sliceLeft;          // lines of the current slice still to run after a stall, 0 if none
+};
+
+// struct for the memory block
+struct MemoryBlock {
+    int start; // holds starting address of memory block
+    int end; // holds ending address of memory block
+    int pid; // process id that is using the memory block
+    int mem; // how much mem is in memory block
+    int age;
+    int active; // if mem block is currently in use by cpu
+};
+
+struct PIDAge {
+    int pid;
+    int active; // if frame is currently in use by cpu
+    int page;   // which page of pid the frame holds
+};
+
+// log-bucketed histogram of tick latencies, kept incrementally from any thread
+// values below 8 are exact, above that each power of two is split into 8 buckets (within 12.5%)
+struct LatencyHistogram {
+    static const int BUCKETS = 8 + 60 * 8;
+    std::atomic<long long> counts[BUCKETS] = {};
+    std::atomic<long long> total{0};
+    std::atomic<long long> sum{0};
+    std::atomic<long long> maxValue{0};
+
+    static int bucket(long long v) {
+        if (v < 8) return v < 0 ? 0 : v;
+        int e = 3;
+        while (v >> (e + 1)) e++;
+        return 8 + (e - 3) * 8 + ((v >> (e - 3)) & 7);
+    }
+    // largest value that falls in bucket b
+    static long long upper(int b) {
+        if (b < 8) return b;
+        int shift = (b - 8) / 8;
+        return ((8LL + (b - 8) % 8) << shift) + (1LL << shift) - 1;
+    }
+    void add(long long v) {
+        counts[bucket(v)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(v, std::memory_order_relaxed);
+        long long m = maxValue.load(std::memory_order_relaxed);
+        while (v > m && !maxValue.compare_exchange_weak(m, v, std::memory_order_relaxed));
+    }
+    // upper bound of the bucket holding the q-th quantile, never above the largest value seen
+    long long percentile(double q) const {
+        long long n = total.load(std::memory_order_relaxed);
+        if (n == 0) return 0;
+        long long rank = std::max(1LL, (long long)std::ceil(q * n));
+        long long seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += counts[b].load(std::memory_order_relaxed);
+            if (seen >= rank) return std::min(upper(b), maxValue.load(std::memory_order_relaxed));
+        }
+        return maxValue;
+    }
+    double mean() const {
+        long long n = total.load(std::memory_order_relaxed);
+        return n > 0 ? (double)sum.load(std::memory_order_relaxed) / n : 0;
+    }
+};
+
+enum TraceType : uint8_t { TR_ARRIVE, TR_DISPATCH, TR_PREEMPT, TR_FINISH, TR_PAGE_IN, TR_PAGE_OUT, TR_ALLOC_FAIL };
+
+struct TraceEvent {
+    int tick;
+    int pid;
+    int arg;      // core for scheduling events, page for paging ones (-1 for a whole flat image), queue for arrivals
+    uint8_t type;
+};
+
+// fixed-size ring of events with a single writer, the oldest events are overwritten when it is full
+struct TraceRing {
+    std::vector<TraceEvent> events;   // power of two long
+    std::atomic<uint64_t> head{0};    // events ever written, the next one goes to head & (size - 1)
+};
+
+// per-process page table, so a process's frames are found without sweeping frameMap
+struct PageTable {
+    std::vector<int> frames;   // frame of each page, -1 if not resident
+    std::vector<char> swapped; // page was evicted to the backing store, faulting it back is a major fault
+    int resident = 0;     // number of pages with a frame
+    uint64_t tlbCores = 0; // cores (mod 64) that ran the process and may cache its translations
+};
+
+struct TLBEntry {
+    int pid;  // address space tag, -1 if the entry is invalid
+    int page;
+    int frame;
+    unsigned stamp; // last use, the oldest way of a set is replaced
+};
+
+// per-core set-associative tlb caching (pid, page) -> frame translations in front of the page tables
+// only its core reads and fills it, other cores queue shootdowns that the core applies before it runs again
+struct TLB {
+    std::vector<TLBEntry> entries; // sets * ways, set s holds entries [s * ways, (s + 1) * ways)
+    int sets = 0;
+    int ways = 0;
+    unsigned clock = 0;
+    int lastPid = -1;         // process that ran last, without asids a different one flushes the tlb
+    long long hits = 0;
+    long long misses = 0;
+    long long shootdowns = 0; // entries invalidated because their page was evicted
+    long long flushes = 0;
+    std::mutex shootMtx;      // guards pendingShoot
+    std::vector<std::pair<int, int>> pendingShoot; // evicted (pid, page) still to invalidate
+    std::atomic<bool> shootPending{false};
+
+    void reset(int numEntries, int numWays) {
+        ways = std::max(1, std::min(numWays, numEntries));
+        sets = numEntries / ways;
+        entries.assign(sets * ways, {-1, 0, 0, 0});
+        lastPid = -1;
+        hits = misses = shootdowns = flushes = 0;
+        pendingShoot.clear();
+        shootPending = false;
+    }
+    TLBEntry* set(int pid, int page) {
+        return &entries[((unsigned)page * 31u + (unsigned)pid) % sets * ways];
+    }
+    // frame of pid's page, -1 on a miss
+    int lookup(int pid, int page) {
+        TLBEntry* e = set(pid, page);
+        for (int w = 0; w < ways; w++) {
+            if (e[w].pid == pid && e[w].page == page) {
+                e[w].stamp = ++clock;
+                return e[w].frame;
+            }
+        }
+        return -1;
+    }
+    void insert(int pid, int page, int frame) {
+        TLBEntry* e = set(pid, page);
+        TLBEntry* victim = e;
+        for (int w = 0; w < ways; w++) {
+            if (e[w].pid == -1) {
+                victim = &e[w];
+                break;
+            }
+            if (e[w].stamp < victim->stamp) victim = &e[w];
+        }
+        *victim = {pid, page, frame, ++clock};
+    }
+    void flush() {
+        for (auto& e : entries) e.pid = -1;
+        flushes++;
+    }
+    // invalidate the translations of pages evicted since the core last ran
+    void applyShootdowns() {
+        if (!shootPending) return;
+        std::lock_guard<std::mutex> lk(shootMtx);
+        for (auto& [pid, page] : pendingShoot) {
+            TLBEntry* e = set(pid, page);
+            for (int w = 0; w < ways; w++) {
+                if (e[w].pid == pid && e[w].page == page) {
+                    e[w].pid = -1;
+                    shootdowns++;
+                }
+            }
+        }
+        pendingShoot.clear();
+        shootPending = false;
+    }
+};
+
+// process table stored densely by pid in fixed-size chunks, records never move once added
+// so cores index it without a lock while the generator and screen -s keep adding
+class ProcessTable {
+public:
+    static const int CHUNK_BITS = 12; // 4096 processes per chunk
+    static const int MAX_CHUNKS = 1 << 16;
+    ProcessTable() : chunks(new std::unique_ptr<ProcessScreen[]>[MAX_CHUNKS]) {}
+    // pids below size() have a slot, empty slots have pid -1
+    int size() const { return count.load(std::memory_order_acquire); }
+    ProcessScreen& operator[](int pid) { return chunks[pid >> CHUNK_BITS][pid & ((1 << CHUNK_BITS) - 1)]; }
+    // only one writer at a time (procMtx)
+    void add(const ProcessScreen& p) {
+        int chunk = p.pid >> CHUNK_BITS;
+        for (int c = 0; c <= chunk; c++) {
+            if (chunks[c]) continue;
+            chunks[c].reset(new ProcessScreen[1 << CHUNK_BITS]());
+            for (int i = 0; i < (1 << CHUNK_BITS); i++) chunks[c][i].pid = -1;
+        }
+        (*this)[p.pid] = p;
+        if (p.pid >= size()) count.store(p.pid + 1, std::memory_order_release);
+    }
+    // drop every process, only while nothing else reads the table
+    void clear() {
+        for (int c = 0; c < MAX_CHUNKS && chunks[c]; c++) chunks[c].reset();
+        count.store(0, std::memory_order_release);
+    }
+private:
+    std::unique_ptr<std::unique_ptr<ProcessScreen[]>[]> chunks;
+    std::atomic<int> count{0};
+};
+
+// ready processes, one queue per core so submitters and the dispatcher don't share one deque
+// core i is dispatched from runQueues[i] and steals from the longest queue when its own is empty
+// each queue has one deque per priority level, only mlfq uses more than level 0
+struct RunQueue {
+    std::mutex mtx;
+    std::vector<std::deque<int>> levels;
+    std::atomic<int> length{0}; // read without the lock to pick where to submit and steal from
+    int bypassed = 0;      // dispatches in a row that went to a process behind the head
+};
+
+// write-behind backing store: allocators queue requests and keep going, a dedicated I/O thread
+// applies them in batches. swap-ins of data still waiting in the queue are answered from memory.
+enum BSOpType { BS_STORE, BS_RETRIEVE, BS_CLEAR };
+struct BSOp {
+    BSOpType type;
+    int pid;
+    int tick;
+    std::chrono::steady_clock::time_point queued;
+    bool skip; // store already satisfied from memory
+};
+
+// point-in-time counters of a simulation
+struct SimStats {
+    long long ticks;
+    long long activeTicks;      // ticks with at least one busy core
+    long long processes;        // created so far
+    long long finished;
+    long long running;          // on a core right now
+    long long ready;            // waiting in the run queues
+    long long instructions;
+    long long pagedIn;
+    long long pagedOut;
+    long long pageRefs;
+    long long majorFaults;
+    long long minorFaults;
+    long long tlbHits;
+    long long tlbMisses;
+    long long dispatchFailures;
+    double cpuUtilization;      // busy cores / cores right now, in percent
+    long long turnaround[4];    // p50, p90, p99 and max in ticks
+    long long waiting[4];
+    long long response[4];
+    double mean[3];             // turnaround, waiting and response means in ticks
+};
+
+struct SnapshotWriter;
+struct SnapshotReader;
+
+// page replacement policy, tracks resident frames and picks eviction victims
+// pinned frames belong to a process on a cpu (or being dispatched) and are never picked
+class ReplacementPolicy {
+public:
+    ReplacementPolicy(int frames) : pinned(frames, 0) {}
+    virtual ~ReplacementPolicy() {}
+    virtual void onLoad(int frame) = 0;   // frame got a new page
+    virtual void onAccess(int frame) = 0; // resident page was referenced again
+    virtual void onFree(int frame) = 0;   // frame went back to the free list
+    virtual int victim() = 0;             // unpinned frame to evict, -1 if none
+    void pin(int frame, bool on) { pinned[frame] = on; }
+    // bookkeeping for checkpoints, load expects a policy built for the same number of frames
+    virtual void save(SnapshotWriter& w);
+    virtual void load(SnapshotReader& r);
+protected:
+    std::vector<char> pinned;
+};
+
+class Scheduler;
+struct SwapSlot;
+
+// every config.txt setting, configure parses a file into a copy and only takes it once it validates
+struct SimConfig {
+    // cpus and scheduling
+    int num_cpu = 0;
+    std::string scheduler;               // fcfs, rr or mlfq
+    int quantum_cycles = 0;
+    int delay_per_exec = 0;
+    int mlfq_levels = 4;
+    std::vector<int> mlfq_quanta;        // lines per execution at each level, defaults to quantum-cycles times 4 per level
+    int mlfq_boost = 5000;               // ticks between priority boosts, 0 turns them off
+    int balance_interval = 64;           // ticks between load-balancing passes, 0 turns them off
+    int dispatch_scan = 8;               // queued processes looked at for one that fits without eviction
+    int max_evictions_per_dispatch = 16; // flat only, paging faults one page at a time. 0 is unlimited
+
+    // workload
+    int batch_process_freq = 0;
+    int min_ins = 0;
+    int max_ins = 0;
+    int min_mem_per_proc = 0;
+    int max_mem_per_proc = 0;
+    unsigned long long seed = 1;         // seeds the workload generator, configure restarts the sequence
+
+    // memory
+    int max_overall_mem = 0;
+    int mem_per_frame = 0;               // equal to max-overall-mem for flat allocation
+    std::string flat_allocator = "free-list"; // free-list (uses fit_policy) or buddy
+    std::string fit_policy = "first-fit";     // first-fit, best-fit, worst-fit or next-fit
+    std::string page_replacement = "fifo";    // fifo, lru, clock or lfu
+    int page_fault_ticks = 2;
+    int opt_oracle_refs = 0;             // how many references to record for the offline opt oracle, 0 = off
+    int tlb_entries = 16;                // 0 turns the tlbs off and every access walks the page table
+    int tlb_ways = 4;
+    int tlb_asid = 1;                    // entries are tagged with the pid, 0 flushes the tlb when a core switches process
+
+    // backing store and tracing
+    int swap_slots = 65536;              // initial slots in the swap file, grows by doubling
+    int bs_queue_depth = 1024;           // bounded, producers wait when it is full
+    int trace_buffer = 65536;            // events per ring
+    int trace_at_start = 0;              // trace from the first tick, headless runs export the trace when they finish
+
+    // why these settings can't run a simulation, empty if they can
+    std::string validate() const;
+};
+
+class Simulator : public SimConfig {
+public:
+    Simulator();
+    ~Simulator();
+
+    // reads config.txt style settings and resets memory
+    // false if the file can't be read, a value is out of range or the clock is running, which leaves every setting as it was
+    // false with the simulator uninitialized if the swap file can't be created
+    bool configure(const std::string& configPath);
+    bool configure(std::istream& config);
+    std::string error;  // why the last configure failed, for the front end to show
+    // creates a process and queues it, an empty name picks the next free pN. -1 if the name is taken
+    int submit(const std::string& name = "");
+    // one tick of the clock followed by every due core's execution, all on the calling thread
+    void tick();
+    void run(long long ticks);
+    // runs the clock and the cores on their own threads until stop()
+    void start();
+    void stop();
+    SimStats stats();
+    // writes the whole simulation to a versioned binary snapshot, pausing the clock while it does
+    bool checkpoint(const std::string& path);
+    // replaces the simulation with a snapshot's, false if the file isn't a snapshot of this version
+    bool restore(const std::string& path);
+    // appends every arrival from now on to a workload trace, until stopRecording()
+    bool recordWorkload(const std::string& path);
+    void stopRecording();
+    // submits a recorded trace's arrivals at their ticks from now on, the generator stays off until it runs out
+    bool replayWorkload(const std::string& path);
+
+    // everything below is the engine itself, left public so front ends and benchmarks can reach in
+
+    // the clock
+    int cpu_cycles = 0;
+    long long num_dispatch_failures = 0;
+    long long num_eviction_limit = 0;    // dispatches that gave up after max-evictions-per-dispatch
+    int dispatchFailedTick = -1;
+    int initialized = 0;
+    int pid = 0;                        // next pid handed out
+    int min_exp;
+    int max_exp;
+    int active_cpu_ticks = 0;
+    std::atomic<int> num_paged_in{0};   // cores page in on faults, so these are shared
+    std::atomic<int> num_paged_out{0};
+    int total_frames = 0;
+
+    // memory manager locks, each guards its own structure so cores don't queue up on one lock
+    std::mutex flatMtx;                 // guards freeMem, freeBySize, buddyFree, takenMem and takenByPid
+    std::deque<std::mutex> frameRegionMtx;        // region r guards frames [r * FRAME_REGION_SIZE, (r + 1) * FRAME_REGION_SIZE)
+    std::mutex bsMtx;                   // guards the swap file, never held together with the above
+
+    // clock -> core signalling, the clock hands each due core one execution per tick
+    std::mutex coreMtx;                 // guards coreWork and pendingCores
+    std::deque<std::condition_variable> coreCv;   // one per core so only cores with work are woken
+    std::condition_variable clockCv;    // cores wake the clock when the tick's work is done
+    std::vector<int> coreWork;          // 1 if the core has an execution pending this tick
+    std::vector<int> coreExecs;         // how many times each cpu was actually able to process smth
+    std::vector<long long> coreInstrs;  // instructions each cpu interpreted
+    int pendingCores = 0;
+    bool coreStop = false;              // set under coreMtx when the clock shuts the cores down
+    std::vector<std::thread> coreThreads;
+    std::thread clockThread;
+    std::atomic<bool> shuttingDown{false};   // asks the clock thread to stop after its current tick
+
+    // ring 0 is the console, 1 the clock, core i writes to ring i + 2
+    std::deque<TraceRing> traceRings;
+    static thread_local int traceRing;
+    std::atomic<bool> tracing{false};
+
+    // record an event on the calling thread's ring, a relaxed load and a branch when tracing is off
+    void trace(TraceType type, int pid, int arg) {
+        if (!tracing.load(std::memory_order_relaxed)) return;
+        TraceRing& r = traceRings[traceRing];
+        uint64_t h = r.head.load(std::memory_order_relaxed);
+        r.events[h & (r.events.size() - 1)] = {cpu_cycles, pid, arg, type};
+        r.head.store(h + 1, std::memory_order_release);
+    }
+
+    // memory: frames and page tables when paging, free and taken blocks when flat
+    std::vector<uint16_t> physMem;  // contents of simulated memory, only symbol tables are ever written
+    std::vector<PIDAge> frameMap;   // frame table, indexed by frame number
+    std::vector<int> freeFrameList; // stack of frames with pid -1, kept in sync on allocate, evict and dealloc
+    std::mutex freeFrameMtx;   // guards freeFrameList
+    std::unordered_map<int, PageTable> pageTables; // pid -> page table
+    std::unique_ptr<ReplacementPolicy> replacementPolicy;
+    std::mutex policyMtx;      // guards replacementPolicy, taken after a frame region lock, never before
+    std::atomic<long long> num_page_refs{0}; // pages touched by running processes
+    std::atomic<long long> num_major_faults{0}; // faults read back from the backing store, they stall the core
+    std::atomic<long long> num_minor_faults{0}; // first touches, zero filled without a stall
+    std::vector<long long> optRefs;    // recorded (pid, page) references
+    std::mutex optMtx;            // guards optRefs and opt_window_faults
+    long long opt_window_faults = 0; // faults the active policy took within the recorded references
+    std::mutex pageTableMtx;   // guards pageTables, taken after a frame region lock, never before
+    std::deque<TLB> tlbs;      // one per cpu, sized by tlb-entries and tlb-ways
+    std::map<int, MemoryBlock> freeMem;  // free memory blocks by start address, neighbours coalesce on insert
+    std::set<std::pair<int, int>> freeBySize; // (mem, start) of every free block, for best and worst fit
+    std::list<MemoryBlock> takenMem;     // taken memory blocks in allocation order, oldest first
+    std::unordered_map<int, std::list<MemoryBlock>::iterator> takenByPid; // pid -> its block in takenMem
+    int nextFitStart = 0;           // address next-fit resumes searching from
+    bool buddy = false;
+    int buddyMaxOrder = 0;
+    std::vector<std::set<int>> buddyFree;     // start addresses of free blocks of size 2^order, per order
+    bool flat = false;
+
+    // processes and their programs
+    ProcessTable processes;                    // every process, indexed by pid
+    std::unordered_map<std::string, int> processIndex;   // process name -> pid
+    std::mutex procMtx;                        // guards processIndex, pid and adding to processes
+    std::vector<CoreProcess> coreProcesses; // for scheduler to keep track of what each core is doing
+    int generating = false; // generating dummy processes
+
+    ProcessScreen getProcByPid(int pid);
+    int findProcess(const std::string& name);
+
+    std::unordered_map<int, std::vector<Instr>> programs; // pid -> program of a process that hasn't finished
+    std::mutex programMtx;                      // guards programs, not the instructions themselves
+    // arrival gives the instruction count, memory and program seed instead of drawing them
+    int addProcess(std::string name, const Arrival* arrival = nullptr);
+    void loadProgram(int pid); // (re)generates the program of pid from its seed
+
+    // workload generation, record and replay, all guarded by procMtx
+    XorShift rng;
+    std::ofstream workloadOut;            // open while recording
+    int recordStart = 0;                  // cpu_cycles when the recording started
+    long long num_recorded = 0;
+    std::vector<Arrival> replayArrivals;
+    size_t replayNext = 0;                // next arrival to submit
+    int replayStart = 0;                  // cpu_cycles when the replay started
+    std::atomic<bool> replaying{false};
+    void replayArrivalsDue();
+
+    // per-core run queues and latency stats
+    std::deque<RunQueue> runQueues;
+    std::atomic<int> nextSubmit{0};      // where the next submission starts looking for the shortest queue
+    long long num_steals = 0;
+    long long num_balance_moves = 0;
+    long long num_dispatch_ahead = 0;    // dispatches that passed over a queue head that didn't fit
+    LatencyHistogram turnaroundHist;     // arrival to completion
+    LatencyHistogram waitingHist;        // total time in run queues, recorded at completion
+    LatencyHistogram responseHist;       // arrival to first dispatch
+
+    void pushRunQueue(int q, int pid);
+    void pushRunQueueFront(int q, int pid);
+    int popRunQueue(int q, bool fitOnly);
+    void submitProcess(int pid);
+    int takeProcess(int cpu, bool fitOnly);
+    void balanceRunQueues();
+    int runQueueLength();
+
+    // flat allocator
+    void eraseFreeBlock(std::map<int, MemoryBlock>::iterator it);
+    void insertFreeBlock(int start, int end);
+    std::map<int, MemoryBlock>::iterator findFreeBlock(int mem);
+    int buddyOrder(int mem);
+    void initBuddy();
+    int buddyAlloc(int order);
+    void buddyRelease(int start, int order);
+    void freeTakenBlock(std::list<MemoryBlock>::iterator it);
+
+    // backing store: a memory-mapped swap file fed by a write-behind I/O thread
+    std::string swapPath;               // backing_store/swap-<process id>-<instance>.bin, removed with the simulator
+    SwapSlot* swapMap = nullptr;        // the mapped swap file
+    size_t swapCapacity = 0;            // slots in the mapped file
+    size_t swapUsed = 0;
+    std::vector<unsigned long long> swapBitmap; // bit set = slot in use
+    size_t swapHint = 0;                // bitmap word the next free-slot search starts from
+    std::unordered_map<int, std::vector<int>> swapSlotsByPid; // pid -> its slots, last stored on top
+    std::unordered_map<int, int> swapImageSlot;     // pid -> slot holding its symbol table while out of memory
+#ifdef _WIN32
+    void* swapFile = (void*)(intptr_t)-1; // INVALID_HANDLE_VALUE
+    void* swapMapping = nullptr;
+#else
+    int swapFd = -1;
+#endif
+    bool mapSwapFile(size_t slots);
+    bool initSwap();
+    int allocSwapSlot();
+    void freeSwapSlot(int slot);
+    void swapOut(int pid, int tick);
+    void swapIn(int pid);
+    void swapDrop(int pid);
+    void storeImage(int pid, const uint16_t* image, int words);
+    bool loadImage(int pid, uint16_t* image, int words);
+
+    std::deque<BSOp> bsQueue;
+    std::mutex bsQueueMtx;              // guards bsQueue, the pending/cancelled counts and the stats below
+    std::condition_variable bsWorkCv;   // wakes the I/O thread
+    std::condition_variable bsSpaceCv;  // wakes producers waiting for room
+    std::condition_variable bsIdleCv;   // wakes BSFlush once the queue is drained
+    std::unordered_map<int, int> bsPendingStores;   // pid -> queued stores not yet taken by the I/O thread
+    std::unordered_map<int, int> bsCancelledStores; // pid -> queued stores the I/O thread should skip
+    std::unordered_map<int, int> bsStoredCount;     // pid -> items in the backing store once the queue drains
+    bool bsBusy = false;                // I/O thread is applying a batch
+    std::thread bsWorker;
+    bool bsStop = false;                // set under bsQueueMtx to let the I/O thread exit once drained
+    size_t bs_max_depth = 0;
+    long long bs_ops_done = 0;
+    long long bs_batches = 0;
+    long long bs_coalesced = 0;         // requests answered or cancelled without touching the swap file
+    long long bs_stalls = 0;            // times a producer found the queue full
+    double bs_latency_us = 0;           // total queue-to-completion time of applied requests
+
+    void bsThread();
+    void bsEnqueue(std::unique_lock<std::mutex>& lk, BSOpType type, int pid);
+    void BSStore(int pid);
+    void BSRetrieve(int pid);
+    void BSClear(int pid);
+    void BSFlush();
+    void startBSThread();
+    void stopBSThread();
+
+    // allocation, paging and execution
+    bool FlatRelease(int pid, uint16_t* image);
+    void freeFrame(int key);
+    std::vector<int> residentFrames(int pid);
+    void PageRelease(int pid);
+    void FlatDealloc(int pid);
+    void PageDealloc(int pid);
+
+    std::unique_ptr<Scheduler> schedulerPolicy;
+    bool coreDue(int& numActualExecs);
+    int codePage(const ProcessScreen& p, int pc);
+    int interpret(ProcessScreen& p, int lines, const int* frames, TLB* tlb, int& faultPage);
+    void coreStep(int cpu);
+    void core(int cpu);
+    void signalCores();
+    bool initializeProgram(std::istream& configFile);
+    bool AllocateFlat(int pid);
+    void restoreImage(int pid);
+    int FlatMemAlloc(int pid);
+    void recordPageRef(int pid, int page, bool fault);
+    bool AllocatePage(int pid, int page);
+    void shootdownTLBs(int pid, int page, uint64_t cores);
+    int EvictPage();
+    void ActivatePages(int pid, bool on);
+    int PagingAlloc(int pid);
+    void touchPage(int pid, int page, int frame);
+    int pageFault(int pid, int page);
+    bool fitsWithoutEviction(int pid);
+    void dispatch(int cpu, int flagCounter);
+    Scheduler* makeScheduler(const std::string& name);
+    void initTLBs();
+    void initCores();
+
+    // snapshots
+    std::string configText;  // config last read by configure, restore replays it to rebuild memory, queues and policies
+    void saveState(SnapshotWriter& w);
+    bool loadState(SnapshotReader& r);
+    void initTrace();
+    void clockTick();
+    void startClock();
+
+    // reports
+    void writeLatency(std::ostream& out);
+    void writeReportUtil(std::ostream& out);
+    void flatFragmentation(double& internal, double& external);
+    long long exportTrace(std::ostream& out);
+    void tlbTotals(long long& hits, long long& misses, long long& shootdowns, long long& flushes);
+    int usedMemory();
+    void writeVmstat(std::ostream& out);
+};
+
+#endif